@@ -0,0 +1,113 @@
+#include "arena_allocator.h"
+#include <algorithm>
+#include <iterator>
+
+ArenaAllocator::ArenaAllocator(size_t capacity) : arena_capacity(capacity) {
+	if (capacity > 0) {
+		free_list[0] = capacity;
+	}
+}
+
+bool ArenaAllocator::allocate(size_t size, ArenaRange &range) {
+	if (size == 0) {
+		return false;
+	}
+	for (auto it = free_list.begin(); it != free_list.end(); ++it) {
+		if (it->second < size) {
+			continue;
+		}
+		range.offset = it->first;
+		range.size = size;
+		if (it->second > size) {
+			free_list[it->first + size] = it->second - size;
+		}
+		free_list.erase(it);
+		used_size += size;
+		return true;
+	}
+	return false;
+}
+
+void ArenaAllocator::free(ArenaRange &range) {
+	if (range.size == 0) {
+		return;
+	}
+	size_t offset = range.offset;
+	size_t size = range.size;
+	used_size -= size;
+	range = {};
+
+	auto next = free_list.lower_bound(offset);
+	if (next != free_list.end() && offset + size == next->first) {
+		size += next->second;
+		next = free_list.erase(next);
+	}
+	if (next != free_list.begin()) {
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset) {
+			prev->second += size;
+			return;
+		}
+	}
+	free_list[offset] = size;
+}
+
+void ArenaAllocator::grow(size_t new_capacity) {
+	if (new_capacity <= arena_capacity) {
+		return;
+	}
+	size_t added = new_capacity - arena_capacity;
+	if (!free_list.empty()) {
+		auto last = std::prev(free_list.end());
+		if (last->first + last->second == arena_capacity) {
+			last->second += added;
+			arena_capacity = new_capacity;
+			return;
+		}
+	}
+	free_list[arena_capacity] = added;
+	arena_capacity = new_capacity;
+}
+
+std::vector<ArenaMove> ArenaAllocator::compact(const std::vector<ArenaRange *> &live) {
+	std::vector<ArenaRange *> sorted;
+	sorted.reserve(live.size());
+	for (ArenaRange *range : live) {
+		if (range->size > 0) {
+			sorted.push_back(range);
+		}
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const ArenaRange *a, const ArenaRange *b) { return a->offset < b->offset; });
+
+	std::vector<ArenaMove> moves;
+	moves.reserve(sorted.size());
+	size_t end = 0;
+	for (ArenaRange *range : sorted) {
+		moves.push_back({ range->offset, end, range->size });
+		range->offset = end;
+		end += range->size;
+	}
+
+	used_size = end;
+	free_list.clear();
+	if (end < arena_capacity) {
+		free_list[end] = arena_capacity - end;
+	}
+	return moves;
+}
+
+size_t ArenaAllocator::largest_free() const {
+	size_t largest = 0;
+	for (const auto &block : free_list) {
+		largest = std::max(largest, block.second);
+	}
+	return largest;
+}
+
+float ArenaAllocator::fragmentation() const {
+	size_t total = arena_capacity - used_size;
+	if (total == 0) {
+		return 0.0f;
+	}
+	return 1.0f - (float)largest_free() / (float)total;
+}
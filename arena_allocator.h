@@ -0,0 +1,56 @@
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+//a block of an arena, in whatever unit the arena counts in. size 0 means nothing is allocated
+struct ArenaRange {
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+//a live range moved by compact, its contents have to be copied from old_offset to its new offset
+struct ArenaMove {
+	size_t old_offset;
+	size_t new_offset;
+	size_t size;
+};
+
+//hands out ranges of a fixed size arena from a free list, first fit, merging freed ranges with their free
+//neighbours. it only does the bookkeeping and never touches memory, so it works the same for CPU and GPU
+//buffers and can be tested without a GL context
+class ArenaAllocator {
+
+public:
+
+	ArenaAllocator(size_t capacity = 0);
+
+	//false when no free block is big enough, range is left unchanged
+	bool allocate(size_t size, ArenaRange &range);
+	//returns the range to the free list and empties it, does nothing for an empty range
+	void free(ArenaRange &range);
+
+	//adds space at the end of the arena
+	void grow(size_t new_capacity);
+	//packs the given ranges, which must be every allocated range, to the start of the arena in offset order
+	//and leaves one free block after them. the ranges are updated and the moves needed to copy their
+	//contents are returned
+	std::vector<ArenaMove> compact(const std::vector<ArenaRange *> &live);
+
+	size_t capacity() const { return arena_capacity; }
+	size_t used() const { return used_size; }
+	size_t largest_free() const;
+	size_t free_blocks() const { return free_list.size(); }
+	//0 when the free space is one block, approaching 1 as it is split into many small ones
+	float fragmentation() const;
+
+private:
+
+	std::map<size_t, size_t> free_list;	//offset -> size, never two adjacent blocks
+	size_t arena_capacity = 0;
+	size_t used_size = 0;
+};
+
+#endif // !ARENA_ALLOCATOR_H
@@ -0,0 +1,57 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <glm/glm.hpp>
+
+//the scripted camera paths voxelite_bench streams chunks around, also driven by the pipeline stress tests.
+//positions are asked for frame by frame in order, a path keeps the state walk needs between frames
+struct CameraPath {
+
+	static constexpr float START_X = 1024.0f, START_Y = 20.0f, START_Z = 1024.0f;
+
+	std::string name;		//line, circle, walk or teleport
+	int frames;				//length of the run, circle goes round once over it
+	float speed;			//blocks the camera moves a frame on line and walk
+	std::mt19937 rng;		//walk's turns
+	glm::vec3 position;
+	glm::vec3 direction;
+
+	CameraPath(const std::string &name, int frames, float speed, uint32_t seed)
+		: name(name), frames(frames), speed(speed), rng(seed), position(start()), direction(1.0f, 0.0f, 0.0f) {}
+
+	static glm::vec3 start() { return glm::vec3(START_X, START_Y, START_Z); }
+	static bool known(const std::string &name) {
+		return name == "line" || name == "circle" || name == "walk" || name == "teleport";
+	}
+
+	//camera position at the given frame of the path
+	glm::vec3 at(int frame) {
+		if (name == "circle") {
+			//a full circle of 512 blocks radius over the run
+			float angle = 6.2831853f * frame / frames;
+			position = start() + glm::vec3(512.0f * std::cos(angle) - 512.0f, 0.0f, 512.0f * std::sin(angle));
+		}
+		else if (name == "walk") {
+			//straight stretches of 120 frames in a random direction
+			if (frame % 120 == 0) {
+				float angle = std::uniform_real_distribution<float>(0.0f, 6.2831853f)(rng);
+				direction = glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+			}
+			position += direction * speed;
+		}
+		else if (name == "teleport") {
+			//jumps far enough every 240 frames that nothing loaded before is kept
+			int jump = frame / 240;
+			position = start() + glm::vec3(jump * 2048.0f, 0.0f, (jump % 2) * 2048.0f);
+		}
+		else {
+			position = start() + glm::vec3(frame * speed, 0.0f, 0.0f);
+		}
+		return position;
+	}
+};
+
+#endif // !CAMERA_PATH_H
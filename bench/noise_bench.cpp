@@ -0,0 +1,152 @@
+//noise microbenchmark: samples per second of the original vector based Noise2D, the scalar Noise::perlin2,
+//and Noise::perlin2_grid / fbm2_grid at every SIMD level the cpu supports, over 32x32 chunk sized grids.
+//also checks that every grid level returns the scalar values
+#include "../noise.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <random>
+
+//the implementation noise.cpp replaced, kept here as the baseline. it allocates eight small vectors a sample
+namespace legacy {
+
+	static std::vector<int> make_permutation() {
+		std::vector<int> permutation(256);
+		for (int i = 0; i < 256; i++) {
+			permutation[i] = i;
+		}
+		std::mt19937 g(1234);
+		std::shuffle(permutation.begin(), permutation.end(), g);
+		permutation.insert(permutation.end(), permutation.begin(), permutation.end());
+		return permutation;
+	}
+
+	static std::vector<int> Permutation = make_permutation();
+
+	static float dot(const std::vector<float>& v1, const std::vector<float>& v2) {
+		return v1[0] * v2[0] + v1[1] * v2[1];
+	}
+
+	static std::vector<float> GetConstantVector(int v) {
+		int h = v & 3;
+		if (h == 0)
+			return { 1.0f, 1.0f };
+		else if (h == 1)
+			return { -1.0f, 1.0f };
+		else if (h == 2)
+			return { -1.0f, -1.0f };
+		else
+			return { 1.0f, -1.0f };
+	}
+
+	static float Noise2D(float x, float y) {
+		int X = (int)std::floor(x) & 255;
+		int Y = (int)std::floor(y) & 255;
+
+		float xf = x - std::floor(x);
+		float yf = y - std::floor(y);
+
+		std::vector<float> topRight = { xf - 1.0f, yf - 1.0f };
+		std::vector<float> topLeft = { xf, yf - 1.0f };
+		std::vector<float> bottomRight = { xf - 1.0f, yf };
+		std::vector<float> bottomLeft = { xf, yf };
+
+		int valueTopRight = Permutation[Permutation[X + 1] + Y + 1];
+		int valueTopLeft = Permutation[Permutation[X] + Y + 1];
+		int valueBottomRight = Permutation[Permutation[X + 1] + Y];
+		int valueBottomLeft = Permutation[Permutation[X] + Y];
+
+		float dotTopRight = dot(topRight, GetConstantVector(valueTopRight));
+		float dotTopLeft = dot(topLeft, GetConstantVector(valueTopLeft));
+		float dotBottomRight = dot(bottomRight, GetConstantVector(valueBottomRight));
+		float dotBottomLeft = dot(bottomLeft, GetConstantVector(valueBottomLeft));
+
+		float u = Fade(xf);
+		float v = Fade(yf);
+
+		return Lerp(u,
+			Lerp(v, dotBottomLeft, dotTopLeft),
+			Lerp(v, dotBottomRight, dotTopRight));
+	}
+}
+
+static const int GRID = 32;
+static const float STEP = 0.05f;
+static volatile float sink;
+
+//runs body(chunk) over enough chunk sized grids to take a measurable time, returns samples per second
+template<typename F>
+static double samples_per_second(int chunks, F body) {
+	auto start = std::chrono::steady_clock::now();
+	for (int c = 0; c < chunks; ++c) {
+		body(c);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return (double)chunks * GRID * GRID / seconds;
+}
+
+int main() {
+	std::vector<float> grid(GRID * GRID);
+	std::vector<float> reference(GRID * GRID);
+	Noise::SimdLevel best = Noise::simd_level();
+	std::printf("cpu supports %s\n", Noise::simd_level_name(best));
+
+	double legacy_rate = samples_per_second(200, [&](int c) {
+		float sum = 0.0f;
+		for (int j = 0; j < GRID; ++j)
+			for (int i = 0; i < GRID; ++i)
+				sum += legacy::Noise2D((c * GRID + i) * STEP, j * STEP);
+		sink = sum;
+	});
+	std::printf("%-28s %12.0f samples/s\n", "legacy Noise2D", legacy_rate);
+
+	double scalar_rate = samples_per_second(4000, [&](int c) {
+		float sum = 0.0f;
+		for (int j = 0; j < GRID; ++j)
+			for (int i = 0; i < GRID; ++i)
+				sum += Noise::perlin2((c * GRID + i) * STEP, j * STEP);
+		sink = sum;
+	});
+	std::printf("%-28s %12.0f samples/s  %6.1fx legacy\n", "Noise::perlin2", scalar_rate, scalar_rate / legacy_rate);
+
+	int mismatches = 0;
+	for (int level = Noise::SIMD_SCALAR; level <= best; ++level) {
+		double rate = samples_per_second(20000, [&](int c) {
+			Noise::perlin2_grid(c * GRID * STEP, 0.0f, STEP, GRID, GRID, grid.data(), (Noise::SimdLevel)level);
+			sink = grid[c & (GRID * GRID - 1)];
+		});
+		char name[64];
+		std::snprintf(name, sizeof(name), "perlin2_grid %s", Noise::simd_level_name((Noise::SimdLevel)level));
+		std::printf("%-28s %12.0f samples/s  %6.1fx legacy\n", name, rate, rate / legacy_rate);
+
+		//odd grids use a step wide enough that a row crosses more than 8 lattice cells
+		for (int c = 0; c < 64; ++c) {
+			float x0 = (c - 32) * GRID * STEP * 3.7f;
+			float step = (c & 1) ? 0.7f : STEP;
+			Noise::perlin2_grid(x0, c * 1.3f, step, GRID, GRID, grid.data(), (Noise::SimdLevel)level);
+			for (int j = 0; j < GRID; ++j)
+				for (int i = 0; i < GRID; ++i)
+					if (grid[j * GRID + i] != Noise::perlin2(x0 + (float)i * step, c * 1.3f + (float)j * step)) ++mismatches;
+		}
+	}
+
+	FbmSettings fbm;
+	fbm.octaves = 4;
+	double fbm_scalar_rate = samples_per_second(1000, [&](int c) {
+		float sum = 0.0f;
+		for (int j = 0; j < GRID; ++j)
+			for (int i = 0; i < GRID; ++i)
+				sum += Noise::fbm2((c * GRID + i) * STEP, j * STEP, fbm);
+		sink = sum;
+	});
+	double fbm_grid_rate = samples_per_second(5000, [&](int c) {
+		Noise::fbm2_grid(c * GRID * STEP, 0.0f, STEP, GRID, GRID, fbm, grid.data());
+		sink = grid[c & (GRID * GRID - 1)];
+	});
+	std::printf("%-28s %12.0f samples/s\n", "fbm2 4 octaves", fbm_scalar_rate);
+	std::printf("%-28s %12.0f samples/s  %6.1fx scalar\n", "fbm2_grid 4 octaves", fbm_grid_rate, fbm_grid_rate / fbm_scalar_rate);
+
+	std::printf("grid samples differing from perlin2: %d\n", mismatches);
+	return mismatches == 0 ? 0 : 1;
+}
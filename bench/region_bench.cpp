@@ -0,0 +1,109 @@
+//region cache benchmark: chunks per second going through STAGE_FILL and STAGE_CARVE (generation) against
+//loading the same chunks back from region files with a freshly opened RegionStore, so every region is
+//mapped again. meshing costs the same on both paths and is timed once on its own.
+//also checks that every loaded chunk has the generated room and blocks
+#include "../region_file.h"
+#include "../generators.h"
+#include "../chunk_rng.h"
+#include "../noise.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+static const int AREA = 32;		//AREA x AREA chunks, 4 regions
+static const uint64_t SEED = 1;
+static const char *DIRECTORY = "region_bench_data";
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void generate(Chunk &chunk, int x, int z) {
+	chunk.reset(x, z);
+	ChunkRng room_rng(SEED, x, z, ChunkRng::STREAM_ROOM);
+	Generators::generate_poolroom(chunk, room_rng);
+	ChunkRng structure_rng(SEED, x, z, ChunkRng::STREAM_STRUCTURES);
+	Generators::carve_room(chunk, structure_rng);
+}
+
+static bool same_chunk(const Chunk &a, const Chunk &b) {
+	const Room &r = a.room, &s = b.room;
+	if (r.x != s.x || r.y != s.y || r.z != s.z || r.width != s.width || r.height != s.height || r.depth != s.depth ||
+		r.chunk_position_x != s.chunk_position_x || r.chunk_position_z != s.chunk_position_z || r.type != s.type) {
+		return false;
+	}
+	for (int i = 0; i < Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE; ++i) {
+		if (a.blocks.get(i) != b.blocks.get(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	std::filesystem::remove_all(DIRECTORY);
+	Noise::set_seed(SEED);
+	Chunk chunk(0, 0);
+	Chunk reference(0, 0);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int x = 0; x < AREA; ++x)
+		for (int z = 0; z < AREA; ++z)
+			generate(chunk, x, z);
+	double generate_rate = AREA * AREA / seconds_since(start);
+
+	size_t bytes = 0;
+	{
+		RegionStore writer;
+		writer.open(DIRECTORY);
+		std::vector<uint8_t> payload;
+		for (int x = 0; x < AREA; ++x) {
+			for (int z = 0; z < AREA; ++z) {
+				generate(chunk, x, z);
+				payload.clear();
+				RegionStore::encode_chunk(chunk, payload);
+				bytes += payload.size();
+				writer.save(chunk);
+			}
+		}
+		writer.flush();
+	}
+
+	RegionStore store;
+	store.open(DIRECTORY);
+	start = std::chrono::steady_clock::now();
+	for (int x = 0; x < AREA; ++x)
+		for (int z = 0; z < AREA; ++z)
+			store.load(x, z, chunk);
+	double load_rate = AREA * AREA / seconds_since(start);
+
+	ChunkBorders borders;
+	start = std::chrono::steady_clock::now();
+	for (int x = 0; x < AREA; ++x) {
+		for (int z = 0; z < AREA; ++z) {
+			store.load(x, z, chunk);
+			chunk.generate_mesh(MESH_GREEDY, borders);
+		}
+	}
+	double mesh_rate = AREA * AREA / seconds_since(start);
+
+	int mismatches = 0;
+	for (int x = 0; x < AREA; ++x) {
+		for (int z = 0; z < AREA; ++z) {
+			generate(reference, x, z);
+			chunk.reset(x, z);
+			if (!store.load(x, z, chunk) || !same_chunk(chunk, reference)) ++mismatches;
+		}
+	}
+
+	std::printf("%-28s %12.0f chunks/s\n", "generate", generate_rate);
+	std::printf("%-28s %12.0f chunks/s  %6.1fx generate\n", "region load", load_rate, load_rate / generate_rate);
+	std::printf("%-28s %12.0f chunks/s\n", "region load + greedy mesh", mesh_rate);
+	std::printf("average record %.0f bytes, %zu loads, %zu misses\n", (double)bytes / (AREA * AREA), (size_t)store.loads, (size_t)store.misses);
+	std::printf("loaded chunks differing from generated: %d\n", mismatches);
+
+	std::filesystem::remove_all(DIRECTORY);
+	return mismatches == 0 ? 0 : 1;
+}
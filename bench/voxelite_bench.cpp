@@ -0,0 +1,292 @@
+//headless chunk pipeline benchmark: streams chunks around a scripted camera path through the ChunkManager
+//worker pool (fill, carve, mesh) with no window and no GL context. the upload step of the main loop is
+//replaced by making every meshed chunk resident straight away, so the numbers are generation and meshing
+//only. prints one JSON object a line on stdout, one for every worker count given to --workers, each a fresh
+//ChunkManager driven along the same path:
+//	chunks/s from the first frame until every requested chunk is resident, STAGE_MESH time percentiles,
+//	vertices and indices per chunk, main loop frame time percentiles, request to resident latency
+//	percentiles, the deepest each queue got, per lock site wait and hold totals and the peak resident set size
+//	(of the whole process, so it only grows over a sweep)
+//
+//usage: voxelite_bench [--path line|circle|walk|teleport] [--frames N] [--speed BLOCKS_PER_FRAME] [--frame-ms MS]
+//                      [--render-distance N] [--workers N[,N...]] [--seed N] [--mesh naive|culled|greedy]
+//                      [--regions DIRECTORY] [--mesh-cache]
+#include "../chunk_manager.h"
+#include "camera_path.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+struct BenchOptions {
+	std::string path = "line";
+	int frames = 2000;
+	float speed = 1.0f;			//blocks the camera moves a frame
+	float frame_ms = 0.0f;		//frames are paced to at least this long, 0 runs them back to back
+	int render_distance = 6;
+	std::vector<int> workers = { ChunkManager::default_worker_count() };
+	uint64_t seed = ChunkManager::DEFAULT_WORLD_SEED;
+	MeshingMode mode = MESH_GREEDY;
+	std::string regions;		//empty: no region files, every chunk is generated
+	bool mesh_cache = false;
+};
+
+static bool parse_options(int argc, char **argv, BenchOptions &options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (arg == "--mesh-cache") {
+			options.mesh_cache = true;
+			continue;
+		}
+		if (!value) {
+			std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+			return false;
+		}
+		++i;
+		if (arg == "--path") options.path = value;
+		else if (arg == "--frames") options.frames = std::max(1, std::atoi(value));
+		else if (arg == "--speed") options.speed = (float)std::atof(value);
+		else if (arg == "--frame-ms") options.frame_ms = std::max(0.0f, (float)std::atof(value));
+		else if (arg == "--render-distance") options.render_distance = std::max(1, std::atoi(value));
+		else if (arg == "--workers") {
+			options.workers.clear();
+			for (const char *count = value; count; count = std::strchr(count, ',')) {
+				count += *count == ',';
+				options.workers.push_back(std::max(1, std::atoi(count)));
+			}
+		}
+		else if (arg == "--seed") options.seed = std::strtoull(value, nullptr, 10);
+		else if (arg == "--regions") options.regions = value;
+		else if (arg == "--mesh") {
+			if (!std::strcmp(value, "naive")) options.mode = MESH_NAIVE;
+			else if (!std::strcmp(value, "culled")) options.mode = MESH_CULLED;
+			else options.mode = MESH_GREEDY;
+		}
+		else {
+			std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+			return false;
+		}
+	}
+	if (!CameraPath::known(options.path)) {
+		std::fprintf(stderr, "unknown path %s\n", options.path.c_str());
+		return false;
+	}
+	return true;
+}
+
+static size_t peak_rss_bytes() {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+	return (size_t)usage.ru_maxrss;
+#else
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+//value below which the given fraction of the sorted samples fall
+template<typename T>
+static double percentile(const std::vector<T> &sorted, double fraction) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	size_t index = std::min(sorted.size() - 1, (size_t)(fraction * (sorted.size() - 1) + 0.5));
+	return (double)sorted[index];
+}
+
+template<typename T>
+static double mean(const std::vector<T> &values) {
+	double sum = 0.0;
+	for (const T &v : values) {
+		sum += (double)v;
+	}
+	return values.empty() ? 0.0 : sum / values.size();
+}
+
+struct BenchSamples {
+	std::vector<float> mesh_ms;
+	std::vector<size_t> vertices;
+	std::vector<size_t> indices;
+	std::vector<float> frame_ms;
+	std::chrono::steady_clock::time_point last_frame = std::chrono::steady_clock::now();
+};
+
+//stands in for Renderer::initChunkBuffers: every meshed chunk is counted and made resident, which hands
+//its CPU mesh to the mesh cache like a real upload would
+static void make_meshed_resident(ChunkManager &manager, BenchSamples &samples) {
+	for (Chunk &chunk : manager.chunks) {
+		if (chunk.state != CHUNK_MESHED) {
+			continue;
+		}
+		samples.mesh_ms.push_back(chunk.mesh_ms);
+		samples.vertices.push_back(chunk.vertices.size());
+		samples.indices.push_back(chunk.indices.size());
+		chunk.state = CHUNK_UPLOADED;
+		manager.make_resident(chunk);
+	}
+}
+
+static bool pipeline_idle(ChunkManager &manager) {
+	std::lock_guard<std::mutex> lock(manager.task_mutex);
+	if (manager.tasks_in_flight != 0 || !manager.chunks_to_load.empty() || manager.ready_chunks.size() != 0) {
+		return false;
+	}
+	for (Chunk &chunk : manager.chunks) {
+		if (chunk.state != CHUNK_RESIDENT) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//one iteration of voxelite's main loop without the rendering
+static void frame(ChunkManager &manager, glm::vec3 position, BenchSamples &samples) {
+	auto start = std::chrono::steady_clock::now();
+	int x = (int)(position.x / ChunkManager::CHUNK_SIZE);
+	int z = (int)(position.z / ChunkManager::CHUNK_SIZE);
+	if (manager.last_x_chunk != x || manager.last_z_chunk != z) {
+		manager.update_visible_chunks(position);
+	}
+	manager.add_pending_chunks();
+	manager.remove_unload_chunks();
+	make_meshed_resident(manager, samples);
+	manager.update_telemetry(std::chrono::duration<float>(start - samples.last_frame).count());
+	samples.last_frame = start;
+	samples.frame_ms.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+//everything one run reports, taken from the manager before it shuts down
+struct BenchResult {
+	double run_seconds = 0.0;
+	double drain_seconds = 0.0;
+	size_t region_loads = 0;
+	size_t mesh_cache_hits = 0;
+	size_t border_publishes = 0;
+	size_t chunks_unloaded = 0;
+	size_t chunks_dropped = 0;
+	ChunkLatencyStats latency;
+	std::vector<LockSiteStats> lock_sites;
+	size_t max_depths[QUEUE_COUNT];
+};
+
+static BenchResult run(const BenchOptions &options, int workers, BenchSamples &samples) {
+	BenchResult result;
+	auto start = std::chrono::steady_clock::now();
+	samples.last_frame = start;
+
+	CameraPath path(options.path, options.frames, options.speed, (uint32_t)options.seed);
+	ChunkManager manager(CameraPath::start(), workers, options.seed, options.regions);
+	manager.meshing_mode = options.mode;
+	manager.mesh_cache.enabled = options.mesh_cache;
+
+	glm::vec3 position = path.position;
+	for (int f = 0; f < options.frames; ++f) {
+		auto frame_start = std::chrono::steady_clock::now();
+		position = path.at(f);
+		frame(manager, position, samples);
+		std::this_thread::sleep_until(frame_start + std::chrono::duration<float, std::milli>(options.frame_ms));
+	}
+	result.run_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	//keeps running frames at the last position until everything requested is resident
+	while (!pipeline_idle(manager)) {
+		frame(manager, position, samples);
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	result.drain_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - result.run_seconds;
+	result.region_loads = manager.regions.loads;
+	result.mesh_cache_hits = manager.mesh_cache.hits;
+	result.border_publishes = manager.border_publishes;
+	result.chunks_unloaded = manager.chunks_unloaded;
+	result.chunks_dropped = manager.chunks_dropped;
+	result.latency = manager.telemetry.latency();
+	result.lock_sites = manager.telemetry.lock_sites();
+	for (int q = 0; q < QUEUE_COUNT; ++q) {
+		result.max_depths[q] = manager.telemetry.max_depth((ChunkQueue)q);
+	}
+	return result;
+}
+
+static void print_result(const BenchOptions &options, int workers, const BenchResult &result, const BenchSamples &samples) {
+	double total_seconds = result.run_seconds + result.drain_seconds;
+
+	std::vector<float> mesh_ms = samples.mesh_ms;
+	std::vector<float> frame_ms = samples.frame_ms;
+	std::vector<size_t> vertices = samples.vertices;
+	std::vector<size_t> indices = samples.indices;
+	std::sort(mesh_ms.begin(), mesh_ms.end());
+	std::sort(frame_ms.begin(), frame_ms.end());
+	std::sort(vertices.begin(), vertices.end());
+	std::sort(indices.begin(), indices.end());
+	const char *mode_names[] = { "naive", "culled", "greedy" };
+	const ChunkLatencyStats &latency = result.latency;
+
+	std::printf("{");
+	std::printf(" \"path\": \"%s\", \"frames\": %d, \"speed\": %.3f, \"frame_ms\": %.3f, \"render_distance\": %d, \"workers\": %d, \"seed\": %llu, \"mesh\": \"%s\",",
+		options.path.c_str(), options.frames, options.speed, options.frame_ms, options.render_distance, workers, (unsigned long long)options.seed, mode_names[options.mode]);
+	std::printf(" \"chunks\": %zu, \"chunks_unloaded\": %zu, \"chunks_dropped\": %zu, \"region_loads\": %zu, \"mesh_cache_hits\": %zu, \"border_publishes\": %zu,",
+		mesh_ms.size(), result.chunks_unloaded, result.chunks_dropped, result.region_loads, result.mesh_cache_hits, result.border_publishes);
+	std::printf(" \"seconds\": %.4f, \"drain_seconds\": %.4f, \"chunks_per_second\": %.1f,",
+		total_seconds, result.drain_seconds, total_seconds > 0.0 ? mesh_ms.size() / total_seconds : 0.0);
+	std::printf(" \"mesh_ms\": { \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"mean\": %.4f },",
+		percentile(mesh_ms, 0.5), percentile(mesh_ms, 0.9), percentile(mesh_ms, 0.99), percentile(mesh_ms, 1.0), mean(mesh_ms));
+	std::printf(" \"vertices_per_chunk\": { \"mean\": %.1f, \"p50\": %.0f, \"max\": %.0f },",
+		mean(vertices), percentile(vertices, 0.5), percentile(vertices, 1.0));
+	std::printf(" \"indices_per_chunk\": { \"mean\": %.1f, \"p50\": %.0f, \"max\": %.0f },",
+		mean(indices), percentile(indices, 0.5), percentile(indices, 1.0));
+	std::printf(" \"frame_ms\": { \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f },",
+		percentile(frame_ms, 0.5), percentile(frame_ms, 0.99), percentile(frame_ms, 1.0));
+	std::printf(" \"resident_latency_ms\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f },",
+		latency.p50_ms, latency.p90_ms, latency.p99_ms, latency.max_ms);
+	std::printf(" \"max_queue_depth\": {");
+	for (int q = 0; q < QUEUE_COUNT; ++q) {
+		std::printf("%s \"%s\": %zu", q ? "," : "", ChunkTelemetry::queue_name((ChunkQueue)q), result.max_depths[q]);
+	}
+	std::printf(" },");
+	std::printf(" \"lock_sites\": [");
+	for (size_t s = 0; s < result.lock_sites.size(); ++s) {
+		const LockSiteStats &site = result.lock_sites[s];
+		std::printf(" { \"site\": \"%s\", \"acquisitions\": %zu, \"contended\": %zu, \"wait_ms\": %.3f, \"hold_ms\": %.3f, \"max_wait_ms\": %.3f, \"max_hold_ms\": %.3f }%s",
+			site.name, site.acquisitions, site.contended, site.wait_ms, site.hold_ms, site.max_wait_ms, site.max_hold_ms, s + 1 < result.lock_sites.size() ? "," : "");
+	}
+	std::printf(" ],");
+	std::printf(" \"peak_rss_bytes\": %zu", peak_rss_bytes());
+	std::printf(" }\n");
+	std::fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+	BenchOptions options;
+	if (!parse_options(argc, argv, options)) {
+		return 2;
+	}
+
+	ChunkManager::RENDER_DISTANCE = options.render_distance;
+	for (int workers : options.workers) {
+		BenchSamples samples;
+		BenchResult result = run(options, workers, samples);
+		print_result(options, workers, result, samples);
+	}
+	return 0;
+}
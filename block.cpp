@@ -17,7 +17,7 @@ Block::Block(BlockType type) {
 	m_blockType = type;
 }
 
-Block::Block(float size) {
+Block::Block(float /*size*/) {
 
 	/*
 	vertices = {
@@ -104,7 +104,7 @@ Block::Block(float size) {
 
 }
 
-void Block::create_verts(float size) {
+void Block::create_verts(float /*size*/) {
 
 	/*
 	vertices = {
@@ -0,0 +1,211 @@
+#include "block_storage.h"
+#include <algorithm>
+#include <cstring>
+
+void BlockStorage::reset(int new_size, BlockType type) {
+	size = new_size;
+	size_shift = 0;
+	while ((1 << size_shift) < size) ++size_shift;
+
+	int n = size >> SECTION_SHIFT;
+	sections.resize(n * n * n);
+	for (Section &section : sections) {
+		section.make_uniform(type);
+	}
+}
+
+void BlockStorage::fill_box(int x0, int y0, int z0, int x1, int y1, int z1, BlockType type) {
+	x0 = std::max(x0, 0); y0 = std::max(y0, 0); z0 = std::max(z0, 0);
+	x1 = std::min(x1, size); y1 = std::min(y1, size); z1 = std::min(z1, size);
+	if (x0 >= x1 || y0 >= y1 || z0 >= z1) {
+		return;
+	}
+
+	for (int sx = x0 >> SECTION_SHIFT; sx <= (x1 - 1) >> SECTION_SHIFT; ++sx) {
+		for (int sy = y0 >> SECTION_SHIFT; sy <= (y1 - 1) >> SECTION_SHIFT; ++sy) {
+			for (int sz = z0 >> SECTION_SHIFT; sz <= (z1 - 1) >> SECTION_SHIFT; ++sz) {
+				//the part of the box inside this section
+				int bx0 = std::max(x0, sx << SECTION_SHIFT), bx1 = std::min(x1, (sx + 1) << SECTION_SHIFT);
+				int by0 = std::max(y0, sy << SECTION_SHIFT), by1 = std::min(y1, (sy + 1) << SECTION_SHIFT);
+				int bz0 = std::max(z0, sz << SECTION_SHIFT), bz1 = std::min(z1, (sz + 1) << SECTION_SHIFT);
+
+				Section &section = sections[section_index(sx, sy, sz)];
+				if ((bx1 - bx0) * (by1 - by0) * (bz1 - bz0) == SECTION_VOLUME) {
+					section.make_uniform(type);
+					continue;
+				}
+				for (int x = bx0; x < bx1; ++x) {
+					for (int y = by0; y < by1; ++y) {
+						for (int z = bz0; z < bz1; ++z) {
+							section.set(local_index(x, y, z), type);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+bool BlockStorage::region_uniform(int x0, int y0, int z0, int x1, int y1, int z1, BlockType &type) const {
+	bool first = true;
+	for (int sx = x0 >> SECTION_SHIFT; sx <= (x1 - 1) >> SECTION_SHIFT; ++sx) {
+		for (int sy = y0 >> SECTION_SHIFT; sy <= (y1 - 1) >> SECTION_SHIFT; ++sy) {
+			for (int sz = z0 >> SECTION_SHIFT; sz <= (z1 - 1) >> SECTION_SHIFT; ++sz) {
+				const Section &section = sections[section_index(sx, sy, sz)];
+				if (!section.uniform() || (!first && section.palette[0] != type)) {
+					return false;
+				}
+				type = section.palette[0];
+				first = false;
+			}
+		}
+	}
+	return !first;
+}
+
+bool BlockStorage::section_uniform(int sx, int sy, int sz, BlockType &type) const {
+	const Section &section = sections[section_index(sx, sy, sz)];
+	type = section.palette[0];
+	return section.uniform();
+}
+
+void BlockStorage::compact() {
+	for (Section &section : sections) {
+		if (section.uniform()) {
+			continue;
+		}
+		BlockType first = section.get(0);
+		bool same = true;
+		for (int i = 1; i < SECTION_VOLUME && same; ++i) {
+			same = section.get(i) == first;
+		}
+		if (same) {
+			section.make_uniform(first);
+		}
+	}
+}
+
+size_t BlockStorage::memory_usage() const {
+	size_t bytes = sections.capacity() * sizeof(Section);
+	for (const Section &section : sections) {
+		bytes += section.words.capacity() * sizeof(uint64_t) + section.palette.capacity() * sizeof(BlockType);
+	}
+	return bytes;
+}
+
+void BlockStorage::serialize(std::vector<uint8_t> &out) const {
+	out.push_back((uint8_t)size_shift);
+	for (const Section &section : sections) {
+		out.push_back((uint8_t)section.bits_per_block);
+		out.push_back((uint8_t)section.palette.size());
+		for (BlockType type : section.palette) {
+			out.push_back((uint8_t)type);
+		}
+		size_t bytes = section.words.size() * sizeof(uint64_t);
+		size_t at = out.size();
+		out.resize(at + bytes);
+		if (bytes) {
+			std::memcpy(&out[at], section.words.data(), bytes);
+		}
+	}
+}
+
+bool BlockStorage::deserialize(const uint8_t *&data, const uint8_t *end) {
+	if (data >= end || *data < SECTION_SHIFT || *data > 10) {
+		return false;
+	}
+	int new_size = 1 << *data++;
+	reset(new_size, INACTIVE);
+
+	for (Section &section : sections) {
+		if (end - data < 2) {
+			return false;
+		}
+		int bits = *data++;
+		int palette_size = *data++;
+		if ((bits != 0 && bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16) ||
+			palette_size < 1 || (bits == 0 && palette_size != 1) || (bits > 0 && palette_size > (1 << bits)) ||
+			end - data < palette_size) {
+			return false;
+		}
+
+		section.palette.clear();
+		for (int i = 0; i < palette_size; ++i) {
+			if (*data > INACTIVE) {
+				return false;
+			}
+			section.palette.push_back((BlockType)*data++);
+		}
+
+		if (bits == 0) {
+			continue;
+		}
+		size_t bytes = (size_t)SECTION_VOLUME * bits / 8;
+		if ((size_t)(end - data) < bytes) {
+			return false;
+		}
+		section.words.resize(bytes / sizeof(uint64_t));
+		std::memcpy(section.words.data(), data, bytes);
+		data += bytes;
+		section.bits_per_block = bits;
+		section.bits_shift = 0;
+		while ((1 << section.bits_shift) < bits) ++section.bits_shift;
+		section.mask = (1ull << bits) - 1;
+
+		//get would index the palette with whatever the words hold, so every index has to be in it
+		if (palette_size < (1 << bits)) {
+			for (uint64_t word : section.words) {
+				for (int shift = 0; shift < 64; shift += bits) {
+					if (((word >> shift) & section.mask) >= (uint64_t)palette_size) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//drops the section's blocks, keeping the capacity for when it gets mixed again
+void BlockStorage::Section::make_uniform(BlockType type) {
+	palette.assign(1, type);
+	words.clear();
+	bits_per_block = 0;
+	bits_shift = 0;
+	mask = 0;
+}
+
+//adds a type missing from the palette. a uniform section gets its 1 bit block array here, a full palette
+//widens the blocks first
+int BlockStorage::Section::add_to_palette(BlockType type) {
+	if (words.empty()) {
+		words.assign(SECTION_VOLUME / 64, 0);
+		bits_per_block = 1;
+		bits_shift = 0;
+		mask = 1;
+	}
+	else if ((int)palette.size() == (1 << bits_per_block)) {
+		repack(bits_per_block * 2);
+	}
+	palette.push_back(type);
+	return (int)palette.size() - 1;
+}
+
+void BlockStorage::Section::repack(int new_bits) {
+	int new_shift = 0;
+	while ((1 << new_shift) < new_bits) ++new_shift;
+	uint64_t new_mask = (1ull << new_bits) - 1;
+
+	std::vector<uint64_t> packed((size_t)SECTION_VOLUME * new_bits / 64, 0);
+	for (int index = 0; index < SECTION_VOLUME; ++index) {
+		int bit = index << bits_shift;
+		uint64_t id = (words[bit >> 6] >> (bit & 63)) & mask;
+		int new_bit = index << new_shift;
+		packed[new_bit >> 6] |= id << (new_bit & 63);
+	}
+
+	words.swap(packed);
+	bits_per_block = new_bits;
+	bits_shift = new_shift;
+	mask = new_mask;
+}
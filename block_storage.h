@@ -0,0 +1,158 @@
+#ifndef BLOCK_STORAGE_H
+#define BLOCK_STORAGE_H
+
+#include <vector>
+#include <cstdint>
+#include "block_type.h"
+
+//palette compressed cube of blocks, split into SECTION_SIZE^3 sections. a section that holds a single type
+//is stored as just that type with no backing array. any other section stores an index into a small palette
+//of the BlockTypes present in it, packed into 64 bit words with 1, 2, 4, 8 or 16 bits a block so entries
+//never straddle two words. adding a type that doesn't fit the palette repacks the section to twice the bits.
+//blocks are addressed by x, y, z or by the chunk index x * size * size + y * size + z
+class BlockStorage {
+
+public:
+
+	static const int SECTION_SIZE = 8;
+	static const int SECTION_SHIFT = 3;		//log2 of SECTION_SIZE
+	static const int SECTION_VOLUME = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
+
+	BlockStorage() = default;
+
+	//size^3 blocks of one type, every section uniform. size must be a power of two no smaller than
+	//SECTION_SIZE. keeps the capacity of the sections' storage
+	void reset(int size, BlockType type);
+
+	BlockType get(int x, int y, int z) const {
+		return section_at(x, y, z).get(local_index(x, y, z));
+	}
+	BlockType get(int index) const {
+		return get(index >> (2 * size_shift), (index >> size_shift) & (size - 1), index & (size - 1));
+	}
+
+	void set(int x, int y, int z, BlockType type) {
+		section_at(x, y, z).set(local_index(x, y, z), type);
+	}
+	void set(int index, BlockType type) {
+		set(index >> (2 * size_shift), (index >> size_shift) & (size - 1), index & (size - 1), type);
+	}
+
+	//sets every block in [x0, x1) x [y0, y1) x [z0, z1), sections the box covers completely become uniform
+	void fill_box(int x0, int y0, int z0, int x1, int y1, int z1, BlockType type);
+
+	//true if every block in [x0, x1) x [y0, y1) x [z0, z1) has the same type, which is written to type.
+	//only looks at whether the overlapped sections are uniform, so a mixed section answers false
+	bool region_uniform(int x0, int y0, int z0, int x1, int y1, int z1, BlockType &type) const;
+	bool is_uniform(BlockType &type) const { return region_uniform(0, 0, 0, size, size, size, type); }
+	bool section_uniform(int sx, int sy, int sz, BlockType &type) const;
+
+	//bulk read, one section at a time in sx, sy, sz order. calls f(sx, sy, sz, type, types): a uniform section
+	//passes its type and a null types without touching any blocks, a mixed one has its words decoded once into
+	//types, SECTION_VOLUME entries indexed (lx * SECTION_SIZE + ly) * SECTION_SIZE + lz. f may set blocks,
+	//the section is decoded before it runs
+	template <typename F>
+	void for_each_section(F &&f) const {
+		BlockType types[SECTION_VOLUME];
+		int n = size >> SECTION_SHIFT;
+		for (int sx = 0; sx < n; ++sx) {
+			for (int sy = 0; sy < n; ++sy) {
+				for (int sz = 0; sz < n; ++sz) {
+					const Section &section = sections[section_index(sx, sy, sz)];
+					if (section.uniform()) {
+						f(sx, sy, sz, section.palette[0], (const BlockType *)nullptr);
+						continue;
+					}
+					int per_word = 64 >> section.bits_shift;
+					int index = 0;
+					for (uint64_t word : section.words) {
+						for (int i = 0; i < per_word; ++i, ++index) {
+							types[index] = section.palette[word & section.mask];
+							word >>= section.bits_per_block;
+						}
+					}
+					f(sx, sy, sz, INACTIVE, (const BlockType *)types);
+				}
+			}
+		}
+	}
+
+	//turns sections that ended up holding a single type back into uniform ones, call once a chunk has
+	//been generated
+	void compact();
+
+	//appends the blocks to out as stored: the size, then per section its bits per block (0 when uniform),
+	//palette and packed words. words are written in host byte order
+	void serialize(std::vector<uint8_t> &out) const;
+	//reads what serialize wrote and advances data past it. returns false on truncated or malformed input,
+	//a packed index outside its section's palette included. the storage then has to be reset before use
+	bool deserialize(const uint8_t *&data, const uint8_t *end);
+
+	int side() const { return size; }
+	int sections_per_side() const { return size >> SECTION_SHIFT; }
+	size_t memory_usage() const;
+
+private:
+
+	struct Section {
+		std::vector<BlockType> palette;		//palette[0] is the type of a uniform section
+		std::vector<uint64_t> words;		//empty while the section is uniform
+		int bits_per_block = 0;
+		int bits_shift = 0;					//log2 of bits_per_block
+		uint64_t mask = 0;
+
+		bool uniform() const { return words.empty(); }
+
+		BlockType get(int index) const {
+			if (words.empty()) {
+				return palette[0];
+			}
+			int bit = index << bits_shift;
+			return palette[(words[bit >> 6] >> (bit & 63)) & mask];
+		}
+
+		void set(int index, BlockType type) {
+			if (words.empty() && palette[0] == type) {
+				return;
+			}
+			uint64_t id = palette_index(type);
+			int bit = index << bits_shift;
+			uint64_t &word = words[bit >> 6];
+			word = (word & ~(mask << (bit & 63))) | (id << (bit & 63));
+		}
+
+		int palette_index(BlockType type) {
+			for (int i = 0; i < (int)palette.size(); ++i) {
+				if (palette[i] == type) {
+					return i;
+				}
+			}
+			return add_to_palette(type);
+		}
+
+		void make_uniform(BlockType type);
+		int add_to_palette(BlockType type);
+		void repack(int new_bits);
+	};
+
+	const Section &section_at(int x, int y, int z) const {
+		return sections[section_index(x >> SECTION_SHIFT, y >> SECTION_SHIFT, z >> SECTION_SHIFT)];
+	}
+	Section &section_at(int x, int y, int z) {
+		return sections[section_index(x >> SECTION_SHIFT, y >> SECTION_SHIFT, z >> SECTION_SHIFT)];
+	}
+	int section_index(int sx, int sy, int sz) const {
+		int n = size >> SECTION_SHIFT;
+		return (sx * n + sy) * n + sz;
+	}
+	static int local_index(int x, int y, int z) {
+		const int m = SECTION_SIZE - 1;
+		return ((x & m) << (2 * SECTION_SHIFT)) | ((y & m) << SECTION_SHIFT) | (z & m);
+	}
+
+	std::vector<Section> sections;
+	int size = 0;
+	int size_shift = 0;		//log2 of size
+};
+
+#endif // !BLOCK_STORAGE_H
@@ -0,0 +1,84 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+//fixed capacity multi producer / multi consumer queue. values are moved in and out so a queue of
+//std::unique_ptr hands ownership from one thread to another. push blocks while the queue is full and
+//pop blocks while it is empty, close() releases every waiting thread so they can be joined
+template<typename T>
+class BoundedQueue {
+
+public:
+
+	explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+	//blocks until there is room, returns false without taking the value if the queue was closed
+	bool push(T &&value) {
+		std::unique_lock<std::mutex> lock(mutex);
+		not_full.wait(lock, [this] { return items.size() < capacity || closed; });
+		if (closed) return false;
+		items.push_back(std::move(value));
+		lock.unlock();
+		not_empty.notify_one();
+		return true;
+	}
+
+	bool try_push(T &&value) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (closed || items.size() >= capacity) return false;
+		items.push_back(std::move(value));
+		lock.unlock();
+		not_empty.notify_one();
+		return true;
+	}
+
+	//blocks until a value is available, returns false once the queue is closed and drained
+	bool pop(T &value) {
+		std::unique_lock<std::mutex> lock(mutex);
+		not_empty.wait(lock, [this] { return !items.empty() || closed; });
+		if (items.empty()) return false;
+		value = std::move(items.front());
+		items.pop_front();
+		lock.unlock();
+		not_full.notify_one();
+		return true;
+	}
+
+	bool try_pop(T &value) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (items.empty()) return false;
+		value = std::move(items.front());
+		items.pop_front();
+		lock.unlock();
+		not_full.notify_one();
+		return true;
+	}
+
+	void close() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		not_full.notify_all();
+		not_empty.notify_all();
+	}
+
+	size_t size() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return items.size();
+	}
+
+private:
+
+	std::mutex mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	std::deque<T> items;
+	size_t capacity;
+	bool closed = false;
+};
+
+#endif // !BOUNDED_QUEUE_H
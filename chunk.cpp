@@ -1,29 +1,36 @@
 
-#include "Chunk.h"
+#include "chunk.h"
 #include "noise.h"
 //#include "poolroom_generator.h"
 #include <iostream>
+#include <algorithm>
 
 
 const int Chunk::CHUNK_SIZE = 32;
 const int Chunk::NUMBER_OF_CUBE_VERTS = 24;
 
-int Chunk::CHUNK_COUNT = 0;
+std::atomic<int> Chunk::CHUNK_COUNT{ 0 };
+
+//corner offsets (in blocks, from the block's minimum corner) and normal for each face.
+//corners are wound counter clockwise when looking at the face from outside, uvs run 0,0 -> 1,0 -> 1,1 -> 0,1.
+//the shaders look normals and tangent frames up by CubeFace, keep FACE_TBN in basic_vs.glsl in sync
+struct CubeFaceDef {
+	int corners[4][3];
+	int normal[3];
+};
+
+static const CubeFaceDef cube_faces[6] = {
+	{ { { 0, 0, 1 },{ 1, 0, 1 },{ 1, 1, 1 },{ 0, 1, 1 } },{ 0, 0, 1 } },	// Front face
+	{ { { 1, 0, 0 },{ 0, 0, 0 },{ 0, 1, 0 },{ 1, 1, 0 } },{ 0, 0, -1 } },	// Back face
+	{ { { 0, 0, 0 },{ 0, 0, 1 },{ 0, 1, 1 },{ 0, 1, 0 } },{ -1, 0, 0 } },	// Left face
+	{ { { 1, 0, 1 },{ 1, 0, 0 },{ 1, 1, 0 },{ 1, 1, 1 } },{ 1, 0, 0 } },	// Right face
+	{ { { 0, 1, 1 },{ 1, 1, 1 },{ 1, 1, 0 },{ 0, 1, 0 } },{ 0, 1, 0 } },	// Top face
+	{ { { 0, 0, 0 },{ 1, 0, 0 },{ 1, 0, 1 },{ 0, 0, 1 } },{ 0, -1, 0 } }	// Bottom face
+};
 
 Chunk::Chunk(int worldx, int worldz) {
 	
-	Chunk::chunk_world_xposition = worldx;
-	Chunk::chunk_world_zposition = worldz;
-	absolute_positionX = CHUNK_SIZE * chunk_world_xposition;
-	absolute_positionZ = CHUNK_SIZE * chunk_world_zposition;
-	buffers_initialized = false;
-	buffers_generated = false;
-	blocks_generated = false;
-	block_number = 0;
-	chunk_id = CHUNK_COUNT;
-	blocks.reserve(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-	// Fill the vector with the desired value
-	blocks.assign(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE, STONE);
+	reset(worldx, worldz);
 	/*
 	for (int x = 0; x < CHUNK_SIZE; x++) {
 		for (int z = 0; z < CHUNK_SIZE; z++) {
@@ -46,105 +53,76 @@ Chunk::Chunk(int worldx, int worldz) {
 	//vertices.reserve(Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE * 256 * 24);
 	//colors.reserve(Chunk::CHUNK_SIZE *Chunk::CHUNK_SIZE *256*24);
 	
-	++CHUNK_COUNT;
 }
 
 Chunk::Chunk(const Chunk &c) {
-	VertexArrayID = c.VertexArrayID;
-	vertex_buffer = c.vertex_buffer;
-	normalBuffer = c.normalBuffer;
-	colorBuffer = c.colorBuffer;
-	tangent_buffer = c.tangent_buffer;
-	bitangent_buffer = c.bitangent_buffer;
-	IndexBuffer = c.IndexBuffer;
-	texture_buffer = c.texture_buffer;
 	chunk_world_xposition = c.chunk_world_xposition;
 	chunk_world_zposition = c.chunk_world_zposition;
 	absolute_positionX = CHUNK_SIZE * chunk_world_xposition;
 	absolute_positionZ = CHUNK_SIZE * chunk_world_zposition;
-	buffers_initialized = c.buffers_initialized;
-	buffers_generated = c.buffers_generated;
+	state = c.state;
+	index_count = c.index_count;
+	resident_index = -1;
+	mesh_min = c.mesh_min;
+	mesh_max = c.mesh_max;
+	mesh_sections = c.mesh_sections;
+	mesh_ms = c.mesh_ms;
 	blocks_generated = c.blocks_generated;
 	prev_room = c.prev_room;
 	room = c.room;
 	portal = c.portal;
 	blocks = c.blocks;
 	vertices = c.vertices;
-	colors = c.colors;
-	normals = c.normals;
 	indices = c.indices;
-	tangents = c.tangents;
-	bitangents = c.bitangents;
-	tex_coords = c.tex_coords;
+	mesh_key = c.mesh_key;
+	sides = c.sides;
 	block_number = c.block_number;
 	chunk_id = c.chunk_id;
 
 }
 
 Chunk::Chunk(Chunk&& other) noexcept
-	: VertexArrayID(other.VertexArrayID),
-	vertex_buffer(other.vertex_buffer),
-	normalBuffer(other.normalBuffer),
-	colorBuffer(other.colorBuffer),
-	IndexBuffer(other.IndexBuffer),
-	tangent_buffer(other.tangent_buffer),
-	bitangent_buffer(other.bitangent_buffer),
-	texture_buffer(other.texture_buffer),
+	: block_number(other.block_number),
+	room(other.room),
+	prev_room(other.prev_room),
+	portal(std::move(other.portal)),
+	chunk_id(other.chunk_id),
 	chunk_world_xposition(other.chunk_world_xposition),
 	chunk_world_zposition(other.chunk_world_zposition),
 	absolute_positionX(other.absolute_positionX),
 	absolute_positionZ(other.absolute_positionZ),
-	buffers_initialized(other.buffers_initialized),
-	buffers_generated(other.buffers_generated),
+	state(other.state),
 	blocks_generated(other.blocks_generated),
-	block_number(other.block_number),
-	prev_room(other.prev_room),
-	room(other.room),
-	//portal(other.portal),
-	chunk_id(other.chunk_id),
+	index_count(other.index_count),
+	resident_index(other.resident_index),
+	mesh_min(other.mesh_min),
+	mesh_max(other.mesh_max),
+	mesh_ms(other.mesh_ms),
+	mesh_sections(other.mesh_sections),
 	vertices(std::move(other.vertices)),
-	tex_coords(std::move(other.tex_coords)),
-	colors(std::move(other.colors)),
-	normals(std::move(other.normals)),
 	indices(std::move(other.indices)),
-	tangents(std::move(other.tangents)),
-	bitangents(std::move(other.bitangents)),
-	portal(std::move(other.portal)),
+	mesh_key(other.mesh_key),
+	sides(std::move(other.sides)),
 	blocks(std::move(other.blocks)){
 
-	
-	other.VertexArrayID = 0;
-	other.vertex_buffer = 0;
-	other.normalBuffer = 0;
-	other.IndexBuffer = 0;
-	other.colorBuffer = 0;
-	other.texture_buffer = 0;
-	other.tangent_buffer = 0;
-	other.bitangent_buffer = 0;
-	
 }
 
 Chunk& Chunk::operator=(Chunk&& other) noexcept {
 	if (this != &other) {  // Prevent self-assignment
-						   // Free existing dynamically allocated resources
-
 		// Move data from `other`
-		VertexArrayID = other.VertexArrayID;
-		vertex_buffer = other.vertex_buffer;
-		normalBuffer = other.normalBuffer;
-		colorBuffer = other.colorBuffer;
-		IndexBuffer = other.IndexBuffer;
-		tangent_buffer = other.tangent_buffer;
-		bitangent_buffer = other.bitangent_buffer;
-		texture_buffer = other.texture_buffer;
 		chunk_world_xposition = other.chunk_world_xposition;
 		chunk_world_zposition = other.chunk_world_zposition;
 		absolute_positionX = other.absolute_positionX;
 		absolute_positionZ = other.absolute_positionZ;
 		block_number = other.block_number;
 		chunk_id = other.chunk_id;
-		buffers_initialized = other.buffers_initialized;
-		buffers_generated = other.buffers_generated;
+		state = other.state;
+		index_count = other.index_count;
+		resident_index = other.resident_index;
+		mesh_min = other.mesh_min;
+		mesh_max = other.mesh_max;
+		mesh_sections = other.mesh_sections;
+		mesh_ms = other.mesh_ms;
 		blocks_generated = other.blocks_generated;
 		prev_room = other.prev_room;
 		room = other.room;
@@ -153,38 +131,31 @@ Chunk& Chunk::operator=(Chunk&& other) noexcept {
 
 								   // Move STL containers
 		vertices = std::move(other.vertices);
-		colors = std::move(other.colors);
-		normals = std::move(other.normals);
 		indices = std::move(other.indices);
+		mesh_key = other.mesh_key;
+		sides = std::move(other.sides);
 		blocks = std::move(other.blocks);
-		tangents = std::move(other.tangents);
-		bitangents = std::move(other.bitangents);
-		tex_coords = std::move(other.tex_coords);
-		
-		other.VertexArrayID = 0;
-		other.vertex_buffer = 0;
-		other.normalBuffer = 0;
-		other.IndexBuffer = 0;
-		other.colorBuffer = 0;
-		other.texture_buffer = 0;
-		other.tangent_buffer = 0;
-		other.bitangent_buffer = 0;
 	}
 	return *this;
 }
 
-void Chunk::generate_buffers() {
-	glGenVertexArrays(1, &VertexArrayID);
-	glGenBuffers(1, &vertex_buffer);
-	glGenBuffers(1, &normalBuffer);
-	glGenBuffers(1, &colorBuffer);
-	glGenBuffers(1, &IndexBuffer);
-	glGenBuffers(1, &texture_buffer);
-	glGenBuffers(1, &tangent_buffer);
-	glGenBuffers(1, &bitangent_buffer);
-	portal.setup_framebuffer();
-	//glGenTextures(1, &textureID);
-	buffers_generated = true;
+//gets the chunk ready to be generated again at new coordinates. blocks and mesh vectors keep their capacity,
+//so a chunk recycled through ChunkPool allocates nothing. the new chunk_id means the backend sees a new chunk
+void Chunk::reset(int worldx, int worldz) {
+	chunk_world_xposition = worldx;
+	chunk_world_zposition = worldz;
+	absolute_positionX = CHUNK_SIZE * chunk_world_xposition;
+	absolute_positionZ = CHUNK_SIZE * chunk_world_zposition;
+	state = CHUNK_REQUESTED;
+	resident_index = -1;
+	blocks_generated = false;
+	chunk_id = CHUNK_COUNT++;	//chunks are constructed on several workers at once
+	room = {};
+	prev_room = {};
+	sides.reset();
+	// Fill the vector with the desired value
+	blocks.reset(CHUNK_SIZE, STONE);
+	clear_mesh();
 }
 
 /*
@@ -198,13 +169,21 @@ void Chunk::generate_hallways(Room prevroom) {
 */
 
 float Chunk::generate_height(int x, int z) {
-	float n = Noise2D(x * 0.05, z * 0.05);
+	float n = Noise::perlin2(x * 0.05f, z * 0.05f);
 	n += 1.0f;
 	n *= 10.0f;
 	
 	return n;
 }
 
+//generate_height for every column of the chunk in one batched noise call, heights[z * CHUNK_SIZE + x]
+void Chunk::generate_heights(float *heights) {
+	Noise::perlin2_grid(absolute_positionX * 0.05f, absolute_positionZ * 0.05f, 0.05f, CHUNK_SIZE, CHUNK_SIZE, heights);
+	for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; ++i) {
+		heights[i] = (heights[i] + 1.0f) * 10.0f;
+	}
+}
+
 void Chunk::generate_mesh() {
 	for (int x = 0; x < CHUNK_SIZE; x++) {
 		for (int y = 0; y < CHUNK_SIZE; y++) {
@@ -216,53 +195,218 @@ void Chunk::generate_mesh() {
 	blocks_generated = true;
 }
 
-void Chunk::create_mesh() {
-	const int CHUNK_VOL = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
-	const int directions[6][3] = { { 1, 0, 0 },{ -1, 0, 0 },{ 0, 1, 0 },
-	{ 0, -1, 0 },{ 0, 0, 1 },{ 0, 0, -1 } };
+void Chunk::generate_mesh(MeshingMode mode, const ChunkBorders &borders) {
+	clear_mesh();
+	//an all air chunk has nothing to mesh
+	BlockType uniform_type;
+	if (blocks.is_uniform(uniform_type) && uniform_type == INACTIVE) {
+		blocks_generated = true;
+		return;
+	}
+	switch (mode) {
+	case MESH_CULLED:
+		generate_culled_mesh(borders);
+		break;
+	case MESH_GREEDY:
+		create_mesh(borders);
+		break;
+	default:
+		generate_mesh();
+		break;
+	}
+}
+
+//same output layout as generate_mesh but only emits the faces of a block that can be seen,
+//buried faces between two active blocks (including across chunk borders) are skipped.
+//walks the chunk a section at a time with for_each_section: all air sections are skipped, in a solid uniform
+//section only the blocks on the section's outside can have a visible face and a mixed one is decoded once
+void Chunk::generate_culled_mesh(const ChunkBorders &borders) {
+	const int S = BlockStorage::SECTION_SIZE;
+	blocks.for_each_section([&](int sx, int sy, int sz, BlockType uniform_type, const BlockType *types) {
+		if (!types && uniform_type == INACTIVE) {
+			return;
+		}
 
-	for (int d = 0; d < 3; ++d) { // d = 0 (x), d = 1 (y), d = 2 (z)
-		int u = (d + 1) % 3;
-		int v = (d + 2) % 3;
+		for (int lx = 0; lx < S; ++lx) {
+			for (int ly = 0; ly < S; ++ly) {
+				for (int lz = 0; lz < S; ++lz) {
+					bool outside = lx == 0 || lx == S - 1 || ly == 0 || ly == S - 1 || lz == 0 || lz == S - 1;
+					if (!types && !outside) {
+						continue;
+					}
+					if (types && types[(lx * S + ly) * S + lz] == INACTIVE) {
+						continue;
+					}
+					int x = sx * S + lx;
+					int y = sy * S + ly;
+					int z = sz * S + lz;
+					bool emitted = false;
+					for (int face = FACE_FRONT; face <= FACE_BOTTOM; ++face) {
+						if (is_face_exposed(x, y, z, (CubeFace)face, borders)) {
+							add_face(x, y, z, (CubeFace)face);
+							emitted = true;
+						}
+					}
+					if (emitted) {
+						++block_number;
+					}
+				}
+			}
+		}
+	});
+	blocks_generated = true;
+}
 
-		std::vector<int> mask(CHUNK_SIZE * CHUNK_SIZE);
+void Chunk::clear_mesh() {
+	vertices.clear();
+	indices.clear();
+	mesh_key = 0;
+	index_count = 0;
+	mesh_min = glm::ivec3(0);
+	mesh_max = glm::ivec3(0);
+	mesh_sections = 0;
+	block_number = 0;
+}
 
-		for (int slice = 0; slice <= CHUNK_SIZE; ++slice) {
-			std::fill(mask.begin(), mask.end(), -1);
+//frees the CPU copy of an uploaded mesh along with its capacity
+void Chunk::release_mesh() {
+	std::vector<ChunkVertex>().swap(vertices);
+	std::vector<int>().swap(indices);
+}
 
-			for (int x = 0; x < CHUNK_SIZE; ++x) {
-				for (int z = 0; z < CHUNK_SIZE; ++z) {
-					int index = x * CHUNK_SIZE + z;
-					int id = -1;
+//finds the box around the mesh and the sections its triangles touch, from the packed vertex positions.
+//a triangle marks every section its own box overlaps, a face lying on a section boundary marks the
+//section above it, whose box includes the boundary
+void Chunk::compute_mesh_bounds() {
+	const int sections = CHUNK_SIZE >> BlockStorage::SECTION_SHIFT;
+	mesh_min = glm::ivec3(CHUNK_SIZE);
+	mesh_max = glm::ivec3(0);
+	mesh_sections = 0;
+	if (indices.empty()) {
+		mesh_min = glm::ivec3(0);
+		return;
+	}
+	//the mask has a bit per section, a chunk with more than 64 of them keeps it 0 and is only tested as a whole
+	bool track_sections = sections * sections * sections <= 64;
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		glm::ivec3 low(CHUNK_SIZE), high(0);
+		for (int k = 0; k < 3; ++k) {
+			uint32_t packed = vertices[indices[i + k]].position;
+			glm::ivec3 p(packed & 1023, (packed >> 10) & 1023, (packed >> 20) & 1023);
+			low = glm::min(low, p);
+			high = glm::max(high, p);
+		}
+		mesh_min = glm::min(mesh_min, low);
+		mesh_max = glm::max(mesh_max, high);
+		if (!track_sections) {
+			continue;
+		}
 
-					if (slice < CHUNK_SIZE) {
-						int a[3] = { x, slice, z };
-						int b[3] = { x, slice - 1, z };
+		glm::ivec3 first, last;
+		for (int a = 0; a < 3; ++a) {
+			first[a] = std::min(low[a] >> BlockStorage::SECTION_SHIFT, sections - 1);
+			last[a] = high[a] > low[a] ? std::min((high[a] - 1) >> BlockStorage::SECTION_SHIFT, sections - 1) : first[a];
+		}
+		for (int sx = first.x; sx <= last.x; ++sx) {
+			for (int sy = first.y; sy <= last.y; ++sy) {
+				for (int sz = first.z; sz <= last.z; ++sz) {
+					mesh_sections |= 1ull << ((sx * sections + sy) * sections + sz);
+				}
+			}
+		}
+	}
+}
+
+//greedy mesher: for every face direction and every slice of the chunk along that direction, the exposed faces
+//are collected into a CHUNK_SIZE x CHUNK_SIZE mask of block types and grown into the largest rectangles of the
+//same type, each emitted as a single quad. covers exactly the same surface as generate_culled_mesh
+void Chunk::create_mesh(const ChunkBorders &borders) {
+	//one mask and one decoded copy of the blocks per worker, reused for every chunk that worker meshes.
+	//every block is read by up to six directions, so the chunk is decoded once up front with for_each_section
+	static thread_local std::vector<int> mask;
+	static thread_local std::vector<BlockType> dense;
+	mask.resize(CHUNK_SIZE * CHUNK_SIZE);
+	dense.resize(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+
+	const int S = BlockStorage::SECTION_SIZE;
+	blocks.for_each_section([&](int sx, int sy, int sz, BlockType uniform_type, const BlockType *types) {
+		for (int lx = 0; lx < S; ++lx) {
+			for (int ly = 0; ly < S; ++ly) {
+				BlockType *row = &dense[((sx * S + lx) * CHUNK_SIZE + sy * S + ly) * CHUNK_SIZE + sz * S];
+				if (types) {
+					std::copy(types + (lx * S + ly) * S, types + (lx * S + ly + 1) * S, row);
+				}
+				else {
+					std::fill(row, row + S, uniform_type);
+				}
+			}
+		}
+	});
 
-						int currBlock = blocks[a[0] * CHUNK_SIZE * CHUNK_SIZE + a[2] * CHUNK_SIZE + a[1]];
-						int prevBlock = (slice > 0) ? blocks[b[0] * CHUNK_SIZE * CHUNK_SIZE + b[2] * CHUNK_SIZE + b[1]] : -1;
+	for (int face = FACE_FRONT; face <= FACE_BOTTOM; ++face) {
+		const int *n = cube_faces[face].normal;
+		int d = (n[0] != 0) ? 0 : (n[1] != 0) ? 1 : 2;	// axis the face points along
+		int u = (d + 1) % 3;
+		int v = (d + 2) % 3;
 
-						if (currBlock != prevBlock && currBlock != 2) {
-							id = currBlock;
-						}
+		for (int slice = 0; slice < CHUNK_SIZE; ++slice) {
+			int pos[3];
+			pos[d] = slice;
+
+			//skip slices that can't have a visible face without building the mask: all air, or uniformly
+			//solid against a uniformly solid next slice inside the chunk
+			int lo[3] = { 0, 0, 0 }, hi[3] = { CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE };
+			lo[d] = slice;
+			hi[d] = slice + 1;
+			BlockType slice_type, next_type;
+			if (blocks.region_uniform(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], slice_type)) {
+				if (slice_type == INACTIVE) {
+					continue;
+				}
+				int next = slice + n[d];
+				lo[d] = next;
+				hi[d] = next + 1;
+				if (next >= 0 && next < CHUNK_SIZE &&
+					blocks.region_uniform(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], next_type) && next_type != INACTIVE) {
+					continue;
+				}
+			}
+
+			for (int a = 0; a < CHUNK_SIZE; ++a) {
+				for (int b = 0; b < CHUNK_SIZE; ++b) {
+					pos[u] = a;
+					pos[v] = b;
+					BlockType type = dense[(pos[0] * CHUNK_SIZE + pos[1]) * CHUNK_SIZE + pos[2]];
+					bool visible = false;
+					if (type != INACTIVE) {
+						int nx = pos[0] + n[0], ny = pos[1] + n[1], nz = pos[2] + n[2];
+						bool inside = nx >= 0 && nx < CHUNK_SIZE && ny >= 0 && ny < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE;
+						visible = inside ? dense[(nx * CHUNK_SIZE + ny) * CHUNK_SIZE + nz] == INACTIVE :
+							is_face_exposed(pos[0], pos[1], pos[2], (CubeFace)face, borders);
 					}
-					mask[index] = id;
+					mask[a * CHUNK_SIZE + b] = visible ? type : -1;
 				}
 			}
 
-			for (int x = 0; x < CHUNK_SIZE; ++x) {
-				for (int z = 0; z < CHUNK_SIZE; ++z) {
-					int id = mask[x * CHUNK_SIZE + z];
-					if (id == -1) continue;
+			for (int a = 0; a < CHUNK_SIZE; ++a) {
+				for (int b = 0; b < CHUNK_SIZE; ) {
+					int id = mask[a * CHUNK_SIZE + b];
+					if (id == -1) {
+						++b;
+						continue;
+					}
 
-					int width = 1, height = 1;
-					while (x + width < CHUNK_SIZE && mask[(x + width) * CHUNK_SIZE + z] == id) {
+					//grow along v first, then along u while every row matches
+					int width = 1;
+					while (b + width < CHUNK_SIZE && mask[a * CHUNK_SIZE + b + width] == id) {
 						width++;
 					}
-					while (z + height < CHUNK_SIZE) {
+					int height = 1;
+					while (a + height < CHUNK_SIZE) {
 						bool valid = true;
 						for (int k = 0; k < width; ++k) {
-							if (mask[(x + k) * CHUNK_SIZE + z + height] != id) {
+							if (mask[(a + height) * CHUNK_SIZE + b + k] != id) {
 								valid = false;
 								break;
 							}
@@ -271,322 +415,135 @@ void Chunk::create_mesh() {
 						height++;
 					}
 
-					for (int i = x; i < x + width; ++i) {
-						for (int j = z; j < z + height; ++j) {
+					for (int i = a; i < a + height; ++i) {
+						for (int j = b; j < b + width; ++j) {
 							mask[i * CHUNK_SIZE + j] = -1;
 						}
 					}
 
-					float normal[3] = { 0.0f, 0.0f, 0.0f };
-					normal[d] = (slice == CHUNK_SIZE) ? -1.0f : 1.0f;
-
-					int a[3] = { x, slice, z };
-					int b[3] = { x + width, slice, z };
-					int c[3] = { x, slice, z + height };
-					int d[3] = { x + width, slice, z + height };
-
+					int size[3];
+					size[d] = 1;
+					size[u] = height;
+					size[v] = width;
+					pos[u] = a;
+					pos[v] = b;
+					add_face(pos[0], pos[1], pos[2], (CubeFace)face, size[0], size[1], size[2]);
 
-					int baseIndex = vertices.size();
-					vertices.insert(vertices.end(), { float(a[0]), float(a[1]), float(a[2]), normal[0], normal[1], normal[2], 1.0f, 1.0f, 1.0f });
-					vertices.insert(vertices.end(), { float(b[0]), float(b[1]), float(b[2]), normal[0], normal[1], normal[2], 1.0f, 1.0f, 1.0f });
-					vertices.insert(vertices.end(), { float(c[0]), float(c[1]), float(c[2]), normal[0], normal[1], normal[2], 1.0f, 1.0f, 1.0f });
-					vertices.insert(vertices.end(), { float(d[0]), float(d[1]), float(d[2]), normal[0], normal[1], normal[2], 1.0f, 1.0f, 1.0f });
-
-					indices.push_back(baseIndex);
-					indices.push_back(baseIndex + 1);
-					indices.push_back(baseIndex + 2);
-					indices.push_back(baseIndex + 2);
-					indices.push_back(baseIndex + 1);
-					indices.push_back(baseIndex + 3);
+					b += width;
 				}
 			}
 		}
 	}
+	blocks_generated = true;
 }
 
-// Function to calculate tangent and bitangent for a triangle
-void Chunk::calculate_tangent_bitangent(
-	const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2,
-	const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec2& uv2,
-	glm::vec3& tangent, glm::vec3& bitangent) {
-
-	glm::vec3 edge1 = v1 - v0;
-	glm::vec3 edge2 = v2 - v0;
-	glm::vec2 deltaUV1 = uv1 - uv0;
-	glm::vec2 deltaUV2 = uv2 - uv0;
-
-	float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-	tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-	tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-	tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-	tangent = glm::normalize(tangent);
-
-	bitangent.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-	bitangent.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-	bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-	bitangent = glm::normalize(bitangent);
-}
-
-
-
 void Chunk::create_cube(int x, int y, int z) {
 
-	
 	int block_index = x * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + z;
-	if (blocks[block_index] == INACTIVE) {
+	if (blocks.get(block_index) == INACTIVE) {
 		return;
 	}
-	/*
-	int left = (x > 0) ? (blocks[(x - 1) * CHUNK_SIZE * CHUNK_SIZE + z * CHUNK_SIZE + y]) : 2;
-	int right = (x < CHUNK_SIZE - 1) ? (blocks[(x + 1) * CHUNK_SIZE * CHUNK_SIZE + z * CHUNK_SIZE + y]) : 2;
 
-	int below = (y > 0) ? (blocks[x * CHUNK_SIZE * CHUNK_SIZE + z * CHUNK_SIZE + (y-1)]) : -1;
-	int above = (y < CHUNK_SIZE - 1) ? (blocks[x * CHUNK_SIZE * CHUNK_SIZE + z * CHUNK_SIZE + (y+1)]) : 2;
-
-	int back = (z > 0) ? (blocks[x * CHUNK_SIZE * CHUNK_SIZE + (z-1) * CHUNK_SIZE + y]) : -1;
-	int front = (z < CHUNK_SIZE - 1) ? (blocks[x * CHUNK_SIZE * CHUNK_SIZE + (z+1) * CHUNK_SIZE + y]) : 2;
-	if (blocks[block_index] == INACTIVE) {
-		return;
-	}
-	if (left != 2 && right != 2 && below != 2 && above != 2 && back != 2 &&
-		front != 2) {
-		return;
+	// 24 vertices per cube, 4 for each face
+	for (int face = FACE_FRONT; face <= FACE_BOTTOM; ++face) {
+		add_face(x, y, z, (CubeFace)face);
 	}
-	*/
 
-	
-	// Create cube vertices based on block_render_size and x, y, z offsets
-	glm::vec3 p0 = {(x - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y - Block::BLOCK_RENDER_SIZE / 2.0f, (z + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-	glm::vec3 p1 = {(x + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y - Block::BLOCK_RENDER_SIZE / 2.0f, (z + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-	glm::vec3 p2 = {(x + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y + Block::BLOCK_RENDER_SIZE / 2.0f, (z + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-	glm::vec3 p3 = {(x - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y + Block::BLOCK_RENDER_SIZE / 2.0f, (z + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-	glm::vec3 p4 = {(x + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y - Block::BLOCK_RENDER_SIZE / 2.0f, (z - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-	glm::vec3 p5 = {(x - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y - Block::BLOCK_RENDER_SIZE / 2.0f, (z - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-	glm::vec3 p6 = {(x - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y + Block::BLOCK_RENDER_SIZE / 2.0f, (z - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-	glm::vec3 p7 = {(x + Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_xposition * Chunk::CHUNK_SIZE), y + Block::BLOCK_RENDER_SIZE / 2.0f, (z - Block::BLOCK_RENDER_SIZE / 2.0f) + (chunk_world_zposition * Chunk::CHUNK_SIZE) };
-
-	//need to know which block we are on because the vertices array is 1D and the values change based on the position in the chunk
-	//using this number we can properly index into it for indices and other stuff
-	int baseVertexIndex = block_number * NUMBER_OF_CUBE_VERTS;
-
-	//Start of the index buffer creation. append to the end of the vector the correct order of the indices
-	// Flatten and insert vertices for each face (24 vertices total per cube)
-	vertices.insert(vertices.end(), { p0.x, p0.y, p0.z, 
-									  p1.x, p1.y, p1.z, 
-									  p2.x, p2.y, p2.z, 
-									  p3.x, p3.y, p3.z }); // Front face
-	vertices.insert(vertices.end(), { p4.x, p4.y, p4.z, 
-									  p5.x, p5.y, p5.z, 
-								      p6.x, p6.y, p6.z, 
-								      p7.x, p7.y, p7.z }); // Back face
-	vertices.insert(vertices.end(), { p5.x, p5.y, p5.z, 
-							          p0.x, p0.y, p0.z, 
-									  p3.x, p3.y, p3.z, 
-							          p6.x, p6.y, p6.z }); // Left face
-	vertices.insert(vertices.end(), { p1.x, p1.y, p1.z, 
-									  p4.x, p4.y, p4.z, 
-									  p7.x, p7.y, p7.z, 
-									  p2.x, p2.y, p2.z }); // Right face
-	vertices.insert(vertices.end(), { p3.x, p3.y, p3.z, 
-									  p2.x, p2.y, p2.z, 
-									  p7.x, p7.y, p7.z, 
-									  p6.x, p6.y, p6.z }); // Top face
-	vertices.insert(vertices.end(), { p5.x, p5.y, p5.z, 
-									  p4.x, p4.y, p4.z, 
-									  p1.x, p1.y, p1.z, 
-									  p0.x, p0.y, p0.z }); // Bottom face
-
-	for (int i = 0; i < 24; ++i) {
-		colors.insert(colors.end(), { block_colors[blocks[block_index]].x, block_colors[blocks[block_index]].y, block_colors[blocks[block_index]].z });
-	}
+	++block_number;
+}
 
-	float texLayer = 0;  // Normalize layer index (0 to 1)
-	//float texLayer = blockType / float(numLayers - 1);  // Normalize layer index (0 to 1)
-
-														// Front face
-														// Front face
-	tex_coords.insert(tex_coords.end(), {
-		0.0f, 0.0f, texLayer,  // bottom-left
-		1.0f, 0.0f, texLayer,  // bottom-right
-		1.0f, 1.0f, texLayer,  // top-right
-		0.0f, 1.0f, texLayer   // top-left
-		});
-
-	// Back face
-	tex_coords.insert(tex_coords.end(), {
-		0.0f, 0.0f, texLayer,  // bottom-left
-		1.0f, 0.0f, texLayer,  // bottom-right
-		1.0f, 1.0f, texLayer,  // top-right
-		0.0f, 1.0f, texLayer   // top-left
-		});
-
-	// Left face
-	tex_coords.insert(tex_coords.end(), {
-		0.0f, 0.0f, texLayer,  // bottom-left
-		1.0f, 0.0f, texLayer,  // bottom-right
-		1.0f, 1.0f, texLayer,  // top-right
-		0.0f, 1.0f, texLayer   // top-left
-		});
-
-	// Right face
-	tex_coords.insert(tex_coords.end(), {
-		0.0f, 0.0f, texLayer,  // bottom-left
-		1.0f, 0.0f, texLayer,  // bottom-right
-		1.0f, 1.0f, texLayer,  // top-right
-		0.0f, 1.0f, texLayer   // top-left
-		});
-
-	// Top face
-	tex_coords.insert(tex_coords.end(), {
-		0.0f, 0.0f, texLayer,  // bottom-left
-		1.0f, 0.0f, texLayer,  // bottom-right
-		1.0f, 1.0f, texLayer,  // top-right
-		0.0f, 1.0f, texLayer   // top-left
-		});
-
-	// Bottom face
-	tex_coords.insert(tex_coords.end(), {
-		0.0f, 0.0f, texLayer,  // bottom-left
-		1.0f, 0.0f, texLayer,  // bottom-right
-		1.0f, 1.0f, texLayer,  // top-right
-		0.0f, 1.0f, texLayer   // top-left
-		});
-
-    // Normals for flat shading (6 faces, each with the same normal for 4 vertices)
-	// Front face normal
-	for (int i = 0; i < 4; ++i) {
-		normals.insert(normals.end(), { 0.0f, 0.0f, 1.0f });
-	}
+//appends one quad for the given face of the block at x, y, z to the mesh. size_x/y/z stretch the quad over
+//that many blocks along each axis (the axis the face points along must stay 1), uvs are stretched with it so
+//the texture repeats once per block
+void Chunk::add_face(int x, int y, int z, CubeFace face, int size_x, int size_y, int size_z) {
+	const CubeFaceDef &def = cube_faces[face];
+	BlockType type = blocks.get(x, y, z);
 
-	// Back face normal
-	for (int i = 0; i < 4; ++i) {
-		normals.insert(normals.end(), { 0.0f, 0.0f, -1.0f });
-	}
+	int baseVertexIndex = vertices.size();
 
-	// Left face normal
-	for (int i = 0; i < 4; ++i) {
-		normals.insert(normals.end(), { -1.0f, 0.0f, 0.0f });
-	}
+	const int size[3] = { size_x, size_y, size_z };
 
-	// Right face normal
-	for (int i = 0; i < 4; ++i) {
-		normals.insert(normals.end(), { 1.0f, 0.0f, 0.0f });
+	//u runs along the corner 0 -> 1 edge and v along the corner 1 -> 2 edge
+	uint32_t su = 1, sv = 1;
+	for (int axis = 0; axis < 3; ++axis) {
+		if (def.corners[0][axis] != def.corners[1][axis]) su = size[axis];
+		if (def.corners[1][axis] != def.corners[2][axis]) sv = size[axis];
 	}
+	const uint32_t uvs[4][2] = { { 0, 0 },{ su, 0 },{ su, sv },{ 0, sv } };
 
-	// Top face normal
 	for (int i = 0; i < 4; ++i) {
-		normals.insert(normals.end(), { 0.0f, 1.0f, 0.0f });
+		uint32_t cx = x + def.corners[i][0] * size_x;
+		uint32_t cy = y + def.corners[i][1] * size_y;
+		uint32_t cz = z + def.corners[i][2] * size_z;
+
+		ChunkVertex vertex;
+		vertex.position = cx | (cy << 10) | (cz << 20);
+		vertex.attributes = (uint32_t)face | (uvs[i][0] << 3) | (uvs[i][1] << 9) | ((uint32_t)type << 15) | (3u << 23);
+		vertices.push_back(vertex);
 	}
 
-	// Bottom face normal
-	for (int i = 0; i < 4; ++i) {
-		normals.insert(normals.end(), { 0.0f, -1.0f, 0.0f });
-	}
-
-															  // Add indices for the cube (use block_number to offset each cube's indices)
 	indices.insert(indices.end(), {
-		// Front face
 		baseVertexIndex + 0, baseVertexIndex + 1, baseVertexIndex + 2,
-		baseVertexIndex + 0, baseVertexIndex + 2, baseVertexIndex + 3,
-
-		// Back face
-		baseVertexIndex + 4, baseVertexIndex + 5, baseVertexIndex + 6,
-		baseVertexIndex + 4, baseVertexIndex + 6, baseVertexIndex + 7,
-
-		// Left face
-		baseVertexIndex + 8, baseVertexIndex + 9, baseVertexIndex + 10,
-		baseVertexIndex + 8, baseVertexIndex + 10, baseVertexIndex + 11,
-
-		// Right face
-		baseVertexIndex + 12, baseVertexIndex + 13, baseVertexIndex + 14,
-		baseVertexIndex + 12, baseVertexIndex + 14, baseVertexIndex + 15,
-
-		// Top face
-		baseVertexIndex + 16, baseVertexIndex + 17, baseVertexIndex + 18,
-		baseVertexIndex + 16, baseVertexIndex + 18, baseVertexIndex + 19,
-
-		// Bottom face
-		baseVertexIndex + 20, baseVertexIndex + 21, baseVertexIndex + 22,
-		baseVertexIndex + 20, baseVertexIndex + 22, baseVertexIndex + 23
+		baseVertexIndex + 0, baseVertexIndex + 2, baseVertexIndex + 3
 	});
+}
 
+//a face is exposed when the block it points at is inactive. faces on the top and bottom of the chunk
+//and faces against a neighbour that isn't loaded are always exposed
+bool Chunk::is_face_exposed(int x, int y, int z, CubeFace face, const ChunkBorders &borders) const {
+	const int *n = cube_faces[face].normal;
+	int nx = x + n[0];
+	int ny = y + n[1];
+	int nz = z + n[2];
 
-	auto calculateTangents = [](const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec2& uv2) {
-		glm::vec3 edge1 = v1 - v0;
-		glm::vec3 edge2 = v2 - v0;
-		glm::vec2 deltaUV1 = uv1 - uv0;
-		glm::vec2 deltaUV2 = uv2 - uv0;
-
-		float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-		glm::vec3 tangent;
-		tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-		tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-		tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-		//tangent = glm::normalize(tangent);
-
-		glm::vec3 bitangent;
-		bitangent.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-		bitangent.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-		bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-		//bitangent = glm::normalize(bitangent);
-
-		return std::make_pair(tangent, bitangent);
-	};
-
-	// Function to insert tangents and bitangents for a triangle
-	auto insertTangentsAndBitangents = [&](const glm::vec3& tangent, const glm::vec3& bitangent, int count) {
-		for (int i = 0; i < count; ++i) {
-			tangents.insert(tangents.end(), { tangent.x, tangent.y, tangent.z });
-			bitangents.insert(bitangents.end(), { bitangent.x, bitangent.y, bitangent.z });
-		}
-	};
-
-	// Calculate tangents and bitangents for each triangle of each face
-		// Front face (two triangles: 0-1-2 and 0-2-3)
-	
-	{
-		auto tb = calculateTangents(p0, p1, p2,{ 0.0f, 0.0f },{ 1.0f, 0.0f },{ 1.0f, 1.0f });
-
-		insertTangentsAndBitangents(tb.first, tb.second, 4); // For triangle 0-1-2
-	}
-
-		// Back face (two triangles: 4-5-6 and 4-6-7)
-	{
-		auto tb = calculateTangents(p4, p5, p6, { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f });
-		insertTangentsAndBitangents(tb.first, tb.second, 4); // For triangle 4-5-6
+	if (ny < 0 || ny >= CHUNK_SIZE) {
+		return true;
 	}
 
-	// Left face (two triangles: 5-0-3 and 5-3-6)
-	{
-		auto tb = calculateTangents(p5, p0, p3, { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f });
-		insertTangentsAndBitangents(tb.first, tb.second, 4); // For triangle 5-0-3
+	if (nx >= 0 && nx < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
+		return blocks.get(nx, ny, nz) == INACTIVE;
 	}
 
-	// Right face (two triangles: 1-4-7 and 1-7-2)
-	{
-		auto tb = calculateTangents(p1, p4, p7, { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f });
-		insertTangentsAndBitangents(tb.first, tb.second, 4); // For triangle 1-4-7
+	//stepped over a horizontal chunk border, look in the copy of the neighbour's touching side
+	const std::vector<BlockType> &side = borders.sides[face];
+	if (side.empty()) {
+		return true;
 	}
+	int along = (face == FACE_LEFT || face == FACE_RIGHT) ? z : x;
+	return side[along * CHUNK_SIZE + ny] == INACTIVE;
+}
 
-	// Top face (two triangles: 3-2-7 and 3-7-6)
-	{
-		auto tb = calculateTangents(p3, p2, p7, { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f });
-		insertTangentsAndBitangents(tb.first, tb.second, 4); // For triangle 3-2-7
+//copies the blocks on one horizontal side of this chunk into side, in the layout ChunkBorders expects.
+//a chunk passes get_border(FACE_RIGHT) to the neighbour on its +x side as that neighbour's FACE_LEFT side
+void Chunk::get_border(CubeFace face, std::vector<BlockType> &side) const {
+	//a uniform side is copied without reading the blocks
+	int lo[3] = { 0, 0, 0 }, hi[3] = { CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE };
+	int edge = (face == FACE_FRONT || face == FACE_RIGHT) ? CHUNK_SIZE - 1 : 0;
+	int axis = (face == FACE_LEFT || face == FACE_RIGHT) ? 0 : 2;
+	lo[axis] = edge;
+	hi[axis] = edge + 1;
+	BlockType uniform_type;
+	if (blocks.region_uniform(lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], uniform_type)) {
+		side.assign(CHUNK_SIZE * CHUNK_SIZE, uniform_type);
+		return;
 	}
 
-	// Bottom face (two triangles: 5-4-1 and 5-1-0)
-	{
-		auto tb = calculateTangents(p5, p4, p1, { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f });
-		insertTangentsAndBitangents(tb.first, tb.second, 4); // For triangle 5-4-1
+	side.resize(CHUNK_SIZE * CHUNK_SIZE);
+	for (int a = 0; a < CHUNK_SIZE; ++a) {
+		for (int y = 0; y < CHUNK_SIZE; ++y) {
+			int x, z;
+			switch (face) {
+			case FACE_FRONT: x = a; z = CHUNK_SIZE - 1; break;
+			case FACE_BACK:  x = a; z = 0; break;
+			case FACE_LEFT:  x = 0; z = a; break;
+			default:         x = CHUNK_SIZE - 1; z = a; break;
+			}
+			side[a * CHUNK_SIZE + y] = blocks.get(x, y, z);
+		}
 	}
-
-
-	++block_number;
 }
 
-void Chunk::configure_portal(Shader &shader, glm::vec3 camera_pos, glm::vec3 camera_front) {
+void Chunk::configure_portal(glm::vec3 camera_pos, glm::vec3 camera_front) {
 
 	//decide where the entrance and exit portal is base on room and next room positions
 	portal.position = { room.chunk_position_x + ((room.x + room.width/2)), room.y + 0.5, room.chunk_position_z + ((room.z + room.depth/2)) };
@@ -595,24 +552,10 @@ void Chunk::configure_portal(Shader &shader, glm::vec3 camera_pos, glm::vec3 cam
 	//move the portal to position in chunk
 	portal.model_matrix = glm::translate(glm::mat4(1.0), glm::vec3(portal.position[0], portal.position[1],portal.position[2]));
 	glm::vec3 relative_camera_pos = camera_pos - portal.position;
-	portal.setup_camera(shader, relative_camera_pos, camera_front);
+	portal.setup_camera(relative_camera_pos, camera_front);
 
 }
 
 
-Chunk::~Chunk() { 
-	// Delete the buffers
-	
-	if (colorBuffer && normalBuffer && IndexBuffer) {
-		glDeleteBuffers(1, &vertex_buffer);
-		glDeleteBuffers(1, &normalBuffer);
-		glDeleteBuffers(1, &colorBuffer);
-		glDeleteBuffers(1, &IndexBuffer);
-		glDeleteBuffers(1, &texture_buffer);
-		glDeleteBuffers(1, &bitangent_buffer);
-		glDeleteVertexArrays(1, &VertexArrayID);
-	}
-	
-	
-	
+Chunk::~Chunk() {
 }
\ No newline at end of file
@@ -2,10 +2,12 @@
 #define CHUNK_H
 
 #include "block.h"
+#include "block_storage.h"
 #include <vector>
 #include <array>
-#include "glad/glad.h"
-#include <iostream>
+#include <atomic>
+#include <memory>
+#include <cstdint>
 #include "portal.h"
 
 struct Room {
@@ -14,6 +16,50 @@ struct Room {
 	BlockType type;
 };
 
+//how a chunk turns its blocks into triangles
+enum MeshingMode {
+	MESH_NAIVE,		//every face of every active block
+	MESH_CULLED,	//only faces that touch an inactive block
+	MESH_GREEDY		//culled faces merged into the largest same-type rectangles
+};
+
+//faces of a cube in the order create_cube has always emitted them
+enum CubeFace {
+	FACE_FRONT,		//+z
+	FACE_BACK,		//-z
+	FACE_LEFT,		//-x
+	FACE_RIGHT,		//+x
+	FACE_TOP,		//+y
+	FACE_BOTTOM		//-y
+};
+
+//where a chunk is on its way from being requested to being drawn, and out again
+enum ChunkState : uint8_t {
+	CHUNK_REQUESTED,	//taken from the pool by STAGE_FILL, blocks not filled yet
+	CHUNK_GENERATED,	//blocks generated or loaded from a region file
+	CHUNK_MESHED,		//CPU mesh built, waiting for its upload
+	CHUNK_UPLOADED,		//mesh copied to the GPU by the render backend
+	CHUNK_RESIDENT,		//in ChunkManager's resident list and drawn, CPU mesh released
+	CHUNK_EVICTING		//being unloaded, on its way back to the pool
+};
+
+//one mesh vertex packed into 8 bytes and uploaded interleaved in a single buffer, unpacked in basic_vs.glsl
+//position:   bits 0-9 x, 10-19 y, 20-29 z of the block corner, relative to the chunk's origin
+//attributes: bits 0-2 CubeFace (selects the normal and tangent frame), 3-8 u, 9-14 v,
+//            15-22 BlockType, 23-24 ambient occlusion (3 = unoccluded)
+struct ChunkVertex {
+	uint32_t position;
+	uint32_t attributes;
+};
+static_assert(sizeof(ChunkVertex) == 8, "ChunkVertex must stay tightly packed");
+
+//copies of the blocks on the touching side of each horizontal neighbour, indexed by the CubeFace
+//pointing at that neighbour. each side is CHUNK_SIZE * CHUNK_SIZE blocks laid out as [a * CHUNK_SIZE + y]
+//where a is the x or z coordinate along the shared side. an empty side means the neighbour isn't loaded
+struct ChunkBorders {
+	std::vector<BlockType> sides[4];
+};
+
 
 class Chunk {
 
@@ -27,58 +73,56 @@ public:
 	Chunk& operator=(Chunk&& other) noexcept;
 	~Chunk();
 
+	void reset(int worldx, int worldz);
+
 	void create_cube(int x, int y, int z);
+	void add_face(int x, int y, int z, CubeFace face, int size_x = 1, int size_y = 1, int size_z = 1);
+	bool is_face_exposed(int x, int y, int z, CubeFace face, const ChunkBorders &borders) const;
+	void get_border(CubeFace face, std::vector<BlockType> &side) const;
 	void generate_mesh();
+	void generate_mesh(MeshingMode mode, const ChunkBorders &borders);
+	void generate_culled_mesh(const ChunkBorders &borders);
+	void clear_mesh();
+	void release_mesh();
+	void compute_mesh_bounds();
 
 	//void generate_hallways(Room room);
 
-	void create_mesh();
-	void generate_buffers();
-
-	void calculate_tangent_bitangent(
-		const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2,
-		const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec2& uv2,
-		glm::vec3& tangent, glm::vec3& bitangent);
+	void create_mesh(const ChunkBorders &borders);
 
-	void configure_portal(Shader &shader, glm::vec3 camera_pos, glm::vec3 camera_front);
+	void configure_portal(glm::vec3 camera_pos, glm::vec3 camera_front);
 
 	static const int CHUNK_SIZE;
 	static const int NUMBER_OF_CUBE_VERTS;
-	static int CHUNK_COUNT;
+	static std::atomic<int> CHUNK_COUNT;
 	int block_number;
 	//Block ***m_pBlocks;
 
 	Room room;
 	Room prev_room;
 	Portal portal;
-	int chunk_id;
+	int chunk_id;				//unique for every load of a chunk, the render backend keys its GPU resources by it
 	int chunk_world_xposition;
 	int chunk_world_zposition;
 	int absolute_positionX;
 	int absolute_positionZ;
-	bool buffers_initialized;
-	bool buffers_generated;
+	ChunkState state = CHUNK_REQUESTED;
 	bool blocks_generated;
-	GLuint VertexArrayID;
-	GLuint vertex_buffer;
-	GLuint normalBuffer;
-	GLuint colorBuffer;
-	GLuint IndexBuffer;
-	GLuint texture_buffer;
-	GLuint tangent_buffer;
-	GLuint bitangent_buffer;
+	uint32_t index_count = 0;	//indices drawn, kept once the CPU mesh is released
+	int resident_index = -1;	//position in ChunkManager::resident, -1 when not resident
+	glm::ivec3 mesh_min{ 0 };	//box around the mesh, in blocks from the chunk's origin
+	glm::ivec3 mesh_max{ 0 };
+	float mesh_ms = 0.0f;		//time STAGE_MESH took to build the mesh or fetch it from the MeshCache
+	uint64_t mesh_sections = 0;	//bit (sx * 4 + sy) * 4 + sz set for every 8^3 section the mesh has triangles in, 0 if unknown
+	//heightmap for the noise terrain the constructor used to build (commented out there). the poolroom generator
+	//carves rooms out of solid chunks and samples no noise, so nothing calls these until terrain comes back
 	float generate_height(int x, int z);
-	std::vector<float> vertices;
+	void generate_heights(float *heights);
+	std::vector<ChunkVertex> vertices;
 	std::vector<int> indices;
-	std::vector<float> normals;
-	std::vector<float> colors;
-	std::vector<float> tex_coords;
-	std::vector<BlockType> blocks;
-
-	std::vector<float> tangents;
-	std::vector<float> bitangents;
-	std::vector<float> flatTangents;
-	std::vector<float> flatBitangents;
+	uint64_t mesh_key = 0;	//MeshCache::mesh_key of the current mesh, 0 when it has none
+	std::shared_ptr<const ChunkBorders> sides;	//this chunk's own sides by the CubeFace they face, set by STAGE_MESH for the BorderSnapshot
+	BlockStorage blocks;	//indexed x * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + z
 };
 
 
@@ -0,0 +1,167 @@
+#include "chunk_arena.h"
+#include <algorithm>
+#include <cstddef>
+
+ChunkArena::~ChunkArena() {
+	if (vao) {
+		glDeleteVertexArrays(1, &vao);
+		glDeleteBuffers(1, &vertices_id);
+		glDeleteBuffers(1, &indices_id);
+	}
+}
+
+void ChunkArena::init(size_t vertices, size_t indices) {
+	vertex_arena = ArenaAllocator(vertices);
+	index_arena = ArenaAllocator(indices);
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vertices_id);
+	glGenBuffers(1, &indices_id);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vertices_id);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertices * sizeof(ChunkVertex), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, indices_id);
+	glBufferData(GL_COPY_WRITE_BUFFER, indices * sizeof(int), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	setup_vao();
+}
+
+const ChunkRanges *ChunkArena::reserve(int chunk_id, size_t vertices, size_t indices) {
+	if (vertices == 0 || indices == 0) {
+		release(chunk_id);
+		return nullptr;
+	}
+	auto found = ranges.find(chunk_id);
+	if (found != ranges.end()) {
+		if (found->second.vertices.size >= vertices && found->second.indices.size >= indices) {
+			return &found->second;
+		}
+		release(chunk_id);
+	}
+
+	while (true) {
+		ArenaRange vertex_range, index_range;
+		if (vertex_arena.allocate(vertices, vertex_range)) {
+			if (index_arena.allocate(indices, index_range)) {
+				ChunkRanges &chunk_ranges = ranges[chunk_id];
+				chunk_ranges.vertices = vertex_range;
+				chunk_ranges.indices = index_range;
+				return &chunk_ranges;
+			}
+			vertex_arena.free(vertex_range);
+		}
+
+		//compacting helps when there is enough free space, just not in one piece
+		size_t free_vertices = vertex_arena.capacity() - vertex_arena.used();
+		size_t free_indices = index_arena.capacity() - index_arena.used();
+		if (free_vertices >= vertices && free_indices >= indices) {
+			relocate(vertex_arena.capacity(), index_arena.capacity());
+			++defragmentations;
+		}
+		else {
+			relocate(std::max(vertex_arena.capacity() * 2, vertex_arena.used() + vertices),
+				std::max(index_arena.capacity() * 2, index_arena.used() + indices));
+			++growths;
+		}
+	}
+}
+
+void ChunkArena::release(int chunk_id) {
+	auto found = ranges.find(chunk_id);
+	if (found == ranges.end()) {
+		return;
+	}
+	vertex_arena.free(found->second.vertices);
+	index_arena.free(found->second.indices);
+	ranges.erase(found);
+}
+
+const ChunkRanges *ChunkArena::find(int chunk_id) const {
+	auto found = ranges.find(chunk_id);
+	return found != ranges.end() ? &found->second : nullptr;
+}
+
+void ChunkArena::maintain() {
+	bool vertices_fragmented = vertex_arena.fragmentation() > DEFRAG_THRESHOLD && vertex_arena.used() * 2 > vertex_arena.capacity();
+	bool indices_fragmented = index_arena.fragmentation() > DEFRAG_THRESHOLD && index_arena.used() * 2 > index_arena.capacity();
+	if (vertices_fragmented || indices_fragmented) {
+		relocate(vertex_arena.capacity(), index_arena.capacity());
+		++defragmentations;
+	}
+}
+
+void ChunkArena::bind() const {
+	glBindVertexArray(vao);
+}
+
+//copies the moved ranges from the old buffer into a new one of the given capacity (in elements of
+//element_size bytes), merging moves that stay contiguous into one copy
+static GLuint copy_into_new_buffer(GLuint old_buffer, const std::vector<ArenaMove> &moves, size_t capacity, size_t element_size) {
+	GLuint new_buffer;
+	glGenBuffers(1, &new_buffer);
+	glBindBuffer(GL_COPY_READ_BUFFER, old_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, capacity * element_size, nullptr, GL_STATIC_DRAW);
+
+	size_t i = 0;
+	while (i < moves.size()) {
+		ArenaMove run = moves[i++];
+		while (i < moves.size() && moves[i].old_offset == run.old_offset + run.size && moves[i].new_offset == run.new_offset + run.size) {
+			run.size += moves[i++].size;
+		}
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+			run.old_offset * element_size, run.new_offset * element_size, run.size * element_size);
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &old_buffer);
+	return new_buffer;
+}
+
+//packs every chunk's ranges to the start of new buffers with the given capacities
+void ChunkArena::relocate(size_t vertex_capacity, size_t index_capacity) {
+	std::vector<ArenaRange *> vertex_ranges, index_ranges;
+	vertex_ranges.reserve(ranges.size());
+	index_ranges.reserve(ranges.size());
+	for (auto &entry : ranges) {
+		vertex_ranges.push_back(&entry.second.vertices);
+		index_ranges.push_back(&entry.second.indices);
+	}
+
+	std::vector<ArenaMove> vertex_moves = vertex_arena.compact(vertex_ranges);
+	std::vector<ArenaMove> index_moves = index_arena.compact(index_ranges);
+	vertex_arena.grow(vertex_capacity);
+	index_arena.grow(index_capacity);
+
+	vertices_id = copy_into_new_buffer(vertices_id, vertex_moves, vertex_arena.capacity(), sizeof(ChunkVertex));
+	indices_id = copy_into_new_buffer(indices_id, index_moves, index_arena.capacity(), sizeof(int));
+	setup_vao();
+}
+
+void ChunkArena::setup_vao() {
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vertices_id);
+
+	// one interleaved buffer of packed ChunkVertex, unpacked in the vertex shader
+	glEnableVertexAttribArray(0);
+	glVertexAttribIPointer(
+		0,                                          // attribute, packed position
+		1,                                          // size
+		GL_UNSIGNED_INT,                            // type
+		sizeof(ChunkVertex),                        // stride
+		(void*)offsetof(ChunkVertex, position)      // array buffer offset
+	);
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribIPointer(
+		1,                                          // attribute, packed face/uv/type/ao
+		1,                                          // size
+		GL_UNSIGNED_INT,                            // type
+		sizeof(ChunkVertex),                        // stride
+		(void*)offsetof(ChunkVertex, attributes)    // array buffer offset
+	);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,71 @@
+#ifndef CHUNK_ARENA_H
+#define CHUNK_ARENA_H
+
+#include <vector>
+#include <unordered_map>
+#include "glad/glad.h"
+#include "arena_allocator.h"
+#include "chunk.h"
+
+//where a chunk's mesh lives in the arena's shared buffers
+struct ChunkRanges {
+	ArenaRange vertices;	//in ChunkVertex
+	ArenaRange indices;		//in indices
+};
+
+//every chunk mesh lives in one shared vertex buffer and one shared index buffer, drawn through a single
+//VAO. a chunk owns a range of each, kept here by Chunk::chunk_id, and is drawn with its vertex range's
+//offset as the base vertex. when a mesh doesn't fit the
+//arena is compacted if its free space is fragmented and grown otherwise, both by copying the live ranges
+//into new buffers on the GPU. main thread only
+class ChunkArena {
+
+public:
+
+	static constexpr size_t INITIAL_VERTICES = 1 << 20;		//8 MB
+	static constexpr size_t INITIAL_INDICES = 3 << 19;		//6 MB
+	static constexpr float DEFRAG_THRESHOLD = 0.5f;
+
+	ChunkArena() = default;
+	~ChunkArena();
+	ChunkArena(const ChunkArena &) = delete;
+	ChunkArena &operator=(const ChunkArena &) = delete;
+
+	//creates the buffers and the VAO, needs a current GL context
+	void init(size_t vertices = INITIAL_VERTICES, size_t indices = INITIAL_INDICES);
+	bool initialized() const { return vao != 0; }
+
+	//makes sure the chunk's ranges hold a mesh of the given size, keeping them when they are already big
+	//enough. nullptr and the ranges released when the mesh is empty
+	const ChunkRanges *reserve(int chunk_id, size_t vertices, size_t indices);
+	void release(int chunk_id);
+	//the chunk's ranges, nullptr when it has none
+	const ChunkRanges *find(int chunk_id) const;
+	//compacts when the free space of either buffer is more fragmented than DEFRAG_THRESHOLD while the
+	//buffer is over half full, call once a frame
+	void maintain();
+
+	void bind() const;
+	GLuint vertex_array() const { return vao; }
+	GLuint vertex_buffer() const { return vertices_id; }
+	GLuint index_buffer() const { return indices_id; }
+
+	const ArenaAllocator &vertex_allocator() const { return vertex_arena; }
+	const ArenaAllocator &index_allocator() const { return index_arena; }
+	size_t defragmentations = 0;
+	size_t growths = 0;
+
+private:
+
+	void relocate(size_t vertex_capacity, size_t index_capacity);
+	void setup_vao();
+
+	GLuint vao = 0;
+	GLuint vertices_id = 0;
+	GLuint indices_id = 0;
+	ArenaAllocator vertex_arena;
+	ArenaAllocator index_arena;
+	std::unordered_map<int, ChunkRanges> ranges;	//by chunk id, only chunks with a mesh in the arena
+};
+
+#endif // !CHUNK_ARENA_H
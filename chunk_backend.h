@@ -0,0 +1,20 @@
+#ifndef CHUNK_BACKEND_H
+#define CHUNK_BACKEND_H
+
+#include "chunk.h"
+
+//the GPU side of the loaded chunks, implemented by whatever draws them. the backend creates a chunk's GPU
+//resources itself the first time it uploads or draws the chunk and keys them by Chunk::chunk_id, chunks
+//hold no GPU handles. ChunkManager only tells it when a chunk is unloaded, so one without a backend (the
+//headless bench, a server) runs the whole pipeline without a GL context
+class ChunkBackend {
+
+public:
+
+	virtual ~ChunkBackend() = default;
+
+	//frees or recycles whatever the backend holds for the chunk, which is being unloaded. main thread only
+	virtual void release_chunk_resources(Chunk &chunk) = 0;
+};
+
+#endif // !CHUNK_BACKEND_H
@@ -0,0 +1,71 @@
+#include "chunk_culler.h"
+#include "chunk.h"
+#include <algorithm>
+
+void ChunkCuller::clear() {
+	origins.clear();
+	sections.clear();
+	for (std::vector<float> &coordinate : bounds) {
+		coordinate.clear();
+	}
+}
+
+void ChunkCuller::add(const glm::vec3 &origin, const glm::ivec3 &mesh_min, const glm::ivec3 &mesh_max, uint64_t mesh_sections) {
+	origins.push_back(origin);
+	sections.push_back(mesh_sections);
+	for (int a = 0; a < 3; ++a) {
+		bounds[a].push_back(origin[a] + mesh_min[a] + CORNER_OFFSET);
+		bounds[a + 3].push_back(origin[a] + mesh_max[a] + CORNER_OFFSET);
+	}
+}
+
+void ChunkCuller::cull(const glm::mat4 &view_projection, std::vector<uint32_t> &visible) {
+	visible.clear();
+	Frustum frustum = Frustum::from_matrix(view_projection);
+	tests.resize(origins.size());
+	FrustumBoxes boxes = { bounds[0].data(), bounds[1].data(), bounds[2].data(),
+		bounds[3].data(), bounds[4].data(), bounds[5].data(), (int)origins.size() };
+	frustum.test_boxes(boxes, tests.data());
+	for (size_t i = 0; i < origins.size(); ++i) {
+		if (tests[i] == FRUSTUM_INSIDE || (tests[i] == FRUSTUM_INTERSECTS && sections_visible(frustum, i))) {
+			visible.push_back((uint32_t)i);
+		}
+	}
+}
+
+//a chunk whose box crosses a plane is only visible if one of the sections its mesh is in, cut down to the
+//mesh's box, isn't completely outside. chunks without section bits count as visible
+bool ChunkCuller::sections_visible(const Frustum &frustum, size_t chunk) {
+	uint64_t mask = sections[chunk];
+	if (mask == 0) {
+		return true;
+	}
+	const int per_side = Chunk::CHUNK_SIZE >> BlockStorage::SECTION_SHIFT;
+	const glm::vec3 &origin = origins[chunk];
+	for (std::vector<float> &coordinate : section_bounds) {
+		coordinate.clear();
+	}
+	for (int bit = 0; bit < 64; ++bit) {
+		if (!((mask >> bit) & 1)) {
+			continue;
+		}
+		int section[3] = { bit / (per_side * per_side), (bit / per_side) % per_side, bit % per_side };
+		for (int a = 0; a < 3; ++a) {
+			float low = origin[a] + (float)(section[a] << BlockStorage::SECTION_SHIFT) + CORNER_OFFSET;
+			section_bounds[a].push_back(std::max(low, bounds[a][chunk]));
+			section_bounds[a + 3].push_back(std::min(low + BlockStorage::SECTION_SIZE, bounds[a + 3][chunk]));
+		}
+	}
+
+	size_t count = section_bounds[0].size();
+	FrustumTest results[64];
+	FrustumBoxes boxes = { section_bounds[0].data(), section_bounds[1].data(), section_bounds[2].data(),
+		section_bounds[3].data(), section_bounds[4].data(), section_bounds[5].data(), (int)count };
+	frustum.test_boxes(boxes, results);
+	for (size_t i = 0; i < count; ++i) {
+		if (results[i] != FRUSTUM_OUTSIDE) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,42 @@
+#ifndef CHUNK_CULLER_H
+#define CHUNK_CULLER_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "frustum.h"
+
+//decides which chunks a render pass can see: the box around each chunk's mesh is tested against the pass's
+//frustum and, for chunks crossing a plane, the boxes of the 8^3 sections the mesh has triangles in.
+//GL-free, ChunkDrawList keeps one next to its draw commands
+class ChunkCuller {
+
+public:
+
+	//basic_vs.glsl places a block corner at corner - 0.5 + chunkOrigin since blocks are centred on integer
+	//coordinates, the boxes are shifted the same way so they hold the geometry as drawn
+	static constexpr float CORNER_OFFSET = -0.5f;
+
+	void clear();
+	//adds a chunk by its world origin and Chunk::mesh_min, mesh_max and mesh_sections
+	void add(const glm::vec3 &origin, const glm::ivec3 &mesh_min, const glm::ivec3 &mesh_max, uint64_t mesh_sections);
+	//fills visible with the indices, in the order they were added, of the chunks not outside the frustum of
+	//view_projection. chunks without section bits are decided by their box alone
+	void cull(const glm::mat4 &view_projection, std::vector<uint32_t> &visible);
+
+	size_t size() const { return origins.size(); }
+	glm::vec3 box_min(size_t chunk) const { return glm::vec3(bounds[0][chunk], bounds[1][chunk], bounds[2][chunk]); }
+	glm::vec3 box_max(size_t chunk) const { return glm::vec3(bounds[3][chunk], bounds[4][chunk], bounds[5][chunk]); }
+
+private:
+
+	bool sections_visible(const Frustum &frustum, size_t chunk);
+
+	std::vector<glm::vec3> origins;
+	std::vector<uint64_t> sections;		//Chunk::mesh_sections of each chunk
+	std::vector<float> bounds[6];		//world space box of each chunk's mesh: min x, y, z, max x, y, z
+	std::vector<float> section_bounds[6];	//boxes of one chunk's sections, reused by sections_visible
+	std::vector<FrustumTest> tests;
+};
+
+#endif // !CHUNK_CULLER_H
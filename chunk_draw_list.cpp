@@ -0,0 +1,131 @@
+#include "chunk_draw_list.h"
+#include <cstring>
+#include <algorithm>
+
+ChunkDrawList::~ChunkDrawList() {
+	if (origin_buffer) {
+		glDeleteBuffers(PASS_COUNT, command_buffers);
+		glDeleteBuffers(1, &origin_buffer);
+	}
+}
+
+void ChunkDrawList::load_multi_draw(GLADloadproc loader) {
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	bool indirect = major > 4 || (major == 4 && minor >= 3);
+	//the origins are picked by base_instance, which a 3.3 context with only the indirect extension ignores
+	bool base_instance = major > 4 || (major == 4 && minor >= 2);
+
+	GLint extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+	for (GLint i = 0; i < extensions && !(indirect && base_instance); ++i) {
+		const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+		if (!name) {
+			continue;
+		}
+		indirect = indirect || std::strcmp(name, "GL_ARB_multi_draw_indirect") == 0;
+		base_instance = base_instance || std::strcmp(name, "GL_ARB_base_instance") == 0;
+	}
+
+	multi_draw = indirect && base_instance ? (MultiDrawElementsIndirectProc)loader("glMultiDrawElementsIndirect") : nullptr;
+}
+
+void ChunkDrawList::build(const std::vector<Chunk *> &resident, ChunkArena &arena) {
+	commands.clear();
+	origins.clear();
+	culler.clear();
+	for (std::vector<DrawElementsIndirectCommand> &pass : visible) {
+		pass.clear();
+	}
+	for (const Chunk *c : resident) {
+		const ChunkRanges *ranges = arena.find(c->chunk_id);
+		if (c->index_count == 0 || !ranges) {
+			continue;
+		}
+		commands.push_back({ c->index_count, 1, (uint32_t)ranges->indices.offset,
+			(int32_t)ranges->vertices.offset, (uint32_t)origins.size() });
+		glm::vec3 origin((float)c->absolute_positionX, 0.0f, (float)c->absolute_positionZ);
+		origins.push_back(origin);
+		culler.add(origin, c->mesh_min, c->mesh_max, c->mesh_sections);
+	}
+
+	if (!multi_draw || commands.empty()) {
+		return;
+	}
+	ensure_buffers(arena);
+	//orphaned every frame, the driver hands out fresh storage while earlier frames still read the old one
+	glBindBuffer(GL_ARRAY_BUFFER, origin_buffer);
+	glBufferData(GL_ARRAY_BUFFER, origins.size() * sizeof(glm::vec3), origins.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ChunkDrawList::cull(RenderPass pass, const glm::mat4 &view_projection) {
+	std::vector<DrawElementsIndirectCommand> &pass_commands = visible[pass];
+	pass_commands.clear();
+	if (!frustum_culling) {
+		pass_commands = commands;
+	}
+	else {
+		culler.cull(view_projection, culled_commands);
+		for (uint32_t i : culled_commands) {
+			pass_commands.push_back(commands[i]);
+		}
+	}
+
+	if (!multi_draw || pass_commands.empty()) {
+		return;
+	}
+	//orphaned like the origins, one buffer per pass so a pass doesn't overwrite commands still being drawn
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffers[pass]);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, pass_commands.size() * sizeof(DrawElementsIndirectCommand), pass_commands.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void ChunkDrawList::draw(ChunkArena &arena, RenderPass pass) {
+	const std::vector<DrawElementsIndirectCommand> &pass_commands = visible[pass];
+	gl_draw_calls = 0;
+	if (pass_commands.empty() || !arena.initialized()) {
+		return;
+	}
+
+	arena.bind();
+	if (multi_draw && use_multi_draw) {
+		glEnableVertexAttribArray(ORIGIN_ATTRIBUTE);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffers[pass]);
+		multi_draw(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)pass_commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		gl_draw_calls = 1;
+	}
+	else {
+		//the origin comes from the attribute's constant value while its array is disabled
+		glDisableVertexAttribArray(ORIGIN_ATTRIBUTE);
+		for (const DrawElementsIndirectCommand &command : pass_commands) {
+			const glm::vec3 &origin = origins[command.base_instance];
+			glVertexAttrib3f(ORIGIN_ATTRIBUTE, origin.x, origin.y, origin.z);
+			glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+				(void*)(command.first_index * sizeof(int)), command.base_vertex);
+		}
+		gl_draw_calls = (int)pass_commands.size();
+	}
+	glBindVertexArray(0);
+}
+
+//creates the per pass command buffers and the origin buffer and points the arena VAO's origin attribute at the latter, one
+//origin per instance so base_instance selects it
+void ChunkDrawList::ensure_buffers(ChunkArena &arena) {
+	if (!origin_buffer) {
+		glGenBuffers(PASS_COUNT, command_buffers);
+		glGenBuffers(1, &origin_buffer);
+	}
+	if (attached_vao == arena.vertex_array()) {
+		return;
+	}
+	arena.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, origin_buffer);
+	glVertexAttribPointer(ORIGIN_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glVertexAttribDivisor(ORIGIN_ATTRIBUTE, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	attached_vao = arena.vertex_array();
+}
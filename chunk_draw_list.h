@@ -0,0 +1,83 @@
+#ifndef CHUNK_DRAW_LIST_H
+#define CHUNK_DRAW_LIST_H
+
+#include <vector>
+#include <cstdint>
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "chunk_arena.h"
+#include "chunk_culler.h"
+
+//layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+	uint32_t count;
+	uint32_t instance_count;
+	uint32_t first_index;
+	int32_t base_vertex;
+	uint32_t base_instance;
+};
+
+//the passes that draw chunks, each from its own camera
+enum RenderPass {
+	PASS_SHADOW,	//from the light, into the shadow map
+	PASS_PORTAL,	//from the portal camera, into the portal's framebuffer
+	PASS_CAMERA,	//from the player's camera
+	PASS_COUNT
+};
+
+//the chunks to draw this frame as one indirect command each, built once a frame. every pass then culls
+//the commands against its frustum with a ChunkCuller, and draws the ones left.
+//each command's base_instance indexes the chunk's world origin in a per instance attribute (location 2),
+//so all of them go out in a single glMultiDrawElementsIndirect. that needs GL 4.3 or ARB_multi_draw_indirect,
+//and GL 4.2 or ARB_base_instance for base_instance to be honoured. without both the same commands are
+//drawn one by one with the origin set as a constant attribute
+class ChunkDrawList {
+
+public:
+
+	static const GLuint ORIGIN_ATTRIBUTE = 2;
+
+	ChunkDrawList() = default;
+	~ChunkDrawList();
+	ChunkDrawList(const ChunkDrawList &) = delete;
+	ChunkDrawList &operator=(const ChunkDrawList &) = delete;
+
+	//looks up glMultiDrawElementsIndirect, which the glad loader doesn't cover, through the window
+	//system's loader, if the context also honours base_instance. without it every draw uses the fallback loop
+	void load_multi_draw(GLADloadproc loader);
+	bool multi_draw_supported() const { return multi_draw != nullptr; }
+
+	//collects the resident chunks that have something to draw with their bounds and uploads the origins
+	void build(const std::vector<Chunk *> &resident, ChunkArena &arena);
+	//keeps the commands of the chunks inside the frustum of view_projection as the pass's visible list
+	//and uploads it, call after build and before drawing the pass
+	void cull(RenderPass pass, const glm::mat4 &view_projection);
+	//draws the pass's visible list with the arena's VAO
+	void draw(ChunkArena &arena, RenderPass pass);
+
+	bool use_multi_draw = true;		//switched off to compare against the fallback
+	bool frustum_culling = true;	//switched off to draw every chunk in every pass
+	int draw_count() const { return (int)commands.size(); }
+	int drawn(RenderPass pass) const { return (int)visible[pass].size(); }
+	int culled(RenderPass pass) const { return draw_count() - drawn(pass); }
+	int gl_draw_calls = 0;			//issued by the last draw
+
+private:
+
+	typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+
+	void ensure_buffers(ChunkArena &arena);
+
+	MultiDrawElementsIndirectProc multi_draw = nullptr;
+	std::vector<DrawElementsIndirectCommand> commands;		//every chunk with a mesh
+	std::vector<DrawElementsIndirectCommand> visible[PASS_COUNT];
+	std::vector<glm::vec3> origins;
+	ChunkCuller culler;					//holds the commands' boxes in command order
+	std::vector<uint32_t> culled_commands;	//indices into commands left by the last cull
+	GLuint command_buffers[PASS_COUNT] = {};
+	GLuint origin_buffer = 0;
+	GLuint attached_vao = 0;		//arena VAO the origin attribute was set up in
+};
+
+#endif // !CHUNK_DRAW_LIST_H
@@ -1,14 +1,16 @@
 
 #include "chunk_manager.h"
 #include "chunk.h"
+#include "noise.h"
 #include <set>
+#include <chrono>
 
 
 
 int ChunkManager::CHUNK_SIZE = 32;				//LxWxH of chunk
 int ChunkManager::RENDER_DISTANCE = 1;			//X-Z area of chunks to render around player position
 
-ChunkManager::ChunkManager(glm::vec3 position) {
+ChunkManager::ChunkManager(glm::vec3 position, int workers, uint64_t seed, const std::string &region_root) {
 	//for logging
 	total_verts = 0;
 	//used for determining if moved of chunk boundaries
@@ -17,20 +19,28 @@ ChunkManager::ChunkManager(glm::vec3 position) {
 	//can use for limiting updates dependent on frames
 	frame_counter = 0;
 	update_interval = 5;
-	// Start worker thread for background chunk generation
+	// Seed generation before any worker can sample noise
+	world_seed = seed;
+	Noise::set_seed(world_seed);
+	// Chunks saved by earlier runs, kept per seed and generator version since either changes what a coordinate holds
+	if (!region_root.empty()) {
+		regions.open(region_root + "/seed_" + std::to_string(world_seed) + "_g" + std::to_string(Generators::GENERATOR_VERSION));
+	}
+	// The first chunks are requested around the start, workers pick those nearest to it first
+	focus_x = (int)(position.x / CHUNK_SIZE);
+	focus_z = (int)(position.z / CHUNK_SIZE);
+	// Start the worker pool for background chunk generation
 	stop_thread = false;
-	worker_thread = std::thread(&ChunkManager::worker_loop, this);
+	worker_count = std::max(1, workers);
+	for (int i = 0; i < worker_count; ++i) {
+		worker_threads.emplace_back(&ChunkManager::worker_loop, this);
+	}
 }
 
-//Loops through all the chunks and generate VAO and VBOs needed if haven't been done
-void ChunkManager::generate_chunk_buffers() {
-	std::lock_guard<std::mutex> lock(chunk_mutex);
-	for (int i = 0; i < chunks.size(); i++) {
-		if (!chunks[i].buffers_generated) {
-			
-			chunks[i].generate_buffers();
-		}
-	}
+//one worker per core, leaving one for the main thread
+int ChunkManager::default_worker_count() {
+	int cores = (int)std::thread::hardware_concurrency();
+	return std::max(1, cores - 1);
 }
 
 //from the players position, render all the chunks around based on the render distance
@@ -42,7 +52,7 @@ void ChunkManager::spawn_initial_chunks(glm::vec3 position){
 
 	for (int x = chunk_positionX - RENDER_DISTANCE; x < chunk_positionX + RENDER_DISTANCE; ++x) {
 		for (int z = chunk_positionZ - RENDER_DISTANCE; z < chunk_positionZ +RENDER_DISTANCE; ++z) {
-			ChunkManager::chunks.push_back(std::move(Chunk(x, z)));
+			ChunkManager::chunks.insert(chunk_pool.acquire(x, z));
 		}
 	}
 }
@@ -59,36 +69,22 @@ void ChunkManager::generate_new_visible_chunks(glm::vec3 position) {
 	int chunk_positionX = position.x / CHUNK_SIZE;
 	int chunk_positionZ = position.z / CHUNK_SIZE;
 
-	// Create a set of existing chunk positions for fast lookup
-	// Use unordered_set for faster lookups
-	std::unordered_set<std::pair<int, int>, PairHash> existing_chunks;
-
-	for (size_t i = chunks.size(); i-- > 0;) {  // Reverse iteration to avoid invalidating indices
-		int distance_from_cameraX = glm::abs(chunks[i].chunk_world_xposition - last_x_chunk);
-		int distance_from_cameraZ = glm::abs(chunks[i].chunk_world_zposition - last_z_chunk);
+	for (Chunk &c : chunks) {
+		int distance_from_cameraX = glm::abs(c.chunk_world_xposition - chunk_positionX);
+		int distance_from_cameraZ = glm::abs(c.chunk_world_zposition - chunk_positionZ);
 
 		if (distance_from_cameraX > RENDER_DISTANCE || distance_from_cameraZ > RENDER_DISTANCE) {
-
-			{
-				//std::lock_guard<std::mutex> lock(chunk_mutex);
-				unload_list.push(i);
-			}					   // Erase the chunk from the main chunks list
-
-		}
-		else {
-			existing_chunks.insert({ chunks[i].chunk_world_xposition, chunks[i].chunk_world_zposition });
+			unload_list.push({ c.chunk_world_xposition, c.chunk_world_zposition });
 		}
 	}
 
 	// Generate new chunks around the player
-	int number_of_generated_chunks = 0;
 	for (int x = chunk_positionX - RENDER_DISTANCE; x <= chunk_positionX + RENDER_DISTANCE; ++x) {
 		for (int z = chunk_positionZ - RENDER_DISTANCE; z <= chunk_positionZ + RENDER_DISTANCE; ++z) {
-			if (existing_chunks.find({ x, z }) == existing_chunks.end() && chunks_to_load_list.find({x,z}) == chunks_to_load_list.end()) {
-				//std::lock_guard<std::mutex> lock(chunk_mutex);
-
+			if (!chunks.find(x, z) && chunks_to_load_list.find({x,z}) == chunks_to_load_list.end()) {
 				chunks_to_load.push({ x, z });
 				chunks_to_load_list.insert({ x, z });
+				telemetry.chunk_requested(x, z);
 			}
 
 		}
@@ -96,43 +92,122 @@ void ChunkManager::generate_new_visible_chunks(glm::vec3 position) {
 	
 	last_x_chunk = chunk_positionX;
 	last_z_chunk = chunk_positionZ;
+	focus_x = chunk_positionX;
+	focus_z = chunk_positionZ;
 
 	
 	 // Wake up worker thread
 	
 }
 
+//hands newly requested chunks to the worker pool and moves every chunk the workers have finished into
+//the main chunk list, where the renderer's initChunkBuffers picks them up for upload
 void ChunkManager::add_pending_chunks() {
+	PROFILE_SCOPE("add_pending_chunks");
 
-	int num_to_process = 2;
-	//move all chunks that are ready to the main chunk list
-	
 	{
-		while (num_to_process > 0 && !chunks_to_load.empty()) {
-			
-			if (pending_chunks.size() >= 2) {
-				chunk_cv.notify_one();
-				return;
-			}
-			//std::lock_guard<std::mutex> lock(chunk_mutex);
-			pending_chunks.push(chunks_to_load.front());
+		//requests past the in-flight limit stay in chunks_to_load until a later frame, the ones the camera
+		//has moved away from by then are dropped
+		TimedLock lock(task_mutex, telemetry, LOCK_ADD_PENDING_TASKS);
+		while (!chunks_to_load.empty() && tasks_in_flight < MAX_QUEUE_SIZE) {
+			std::pair<int, int> coords = chunks_to_load.front();
 			chunks_to_load.pop();
-			num_to_process--;
+			if (!in_range(coords.first, coords.second)) {
+				chunks_to_load_list.erase(coords);
+				telemetry.chunk_cancelled(coords.first, coords.second);
+				continue;
+			}
+			tasks.push_back({ coords.first, coords.second, STAGE_FILL, nullptr });
+			++tasks_in_flight;
+		}
+	}
+	task_cv.notify_all();
+
+	std::unique_ptr<Chunk> new_chunk;
+	while (ready_chunks.try_pop(new_chunk)) {
+		if (!in_range(new_chunk->chunk_world_xposition, new_chunk->chunk_world_zposition)) {
+			drop_arrived_chunk(std::move(new_chunk));
+			continue;
 		}
-		//chunks_to_load_list.clear();
-		//chunk_cv.notify_one();
+		rooms.push_back(new_chunk->room);
+		total_verts += new_chunk->vertices.size();
+		//if chunk list isnt empty set the last chunk's next room to the newly created chunks room
+		if (chunks.last_inserted >= 0) {
+			chunks.at_slot(chunks.last_inserted).prev_room = rooms.back(); //this needs to be changed to the variable next_room
+		}
+		staged_borders[{ new_chunk->chunk_world_xposition, new_chunk->chunk_world_zposition }] = new_chunk->sides;
+		staged_borders_changed = true;
+		chunks.insert(std::move(new_chunk));
+	}
+	publish_borders();
+}
+
+//swaps the staged borders in for the workers' next STAGE_MESH, the copy is made before taking the lock
+//so the swap is the only thing done under it. workers still meshing against the old snapshot keep it
+//alive until they're done, the last one to let go frees it
+void ChunkManager::publish_borders() {
+	if (!staged_borders_changed) {
+		return;
+	}
+	PROFILE_SCOPE("publish_borders");
+	std::shared_ptr<const BorderSnapshot> snapshot = std::make_shared<const BorderSnapshot>(staged_borders);
+	{
+		TimedLock lock(border_mutex, telemetry, LOCK_PUBLISH_BORDERS);
+		published_borders.swap(snapshot);
 	}
+	staged_borders_changed = false;
+	++border_publishes;
+}
+
+//true when the chunk at chunk_x, chunk_z is within RENDER_DISTANCE of the camera's chunk
+bool ChunkManager::in_range(int chunk_x, int chunk_z) const {
+	return std::abs(chunk_x - last_x_chunk) <= RENDER_DISTANCE && std::abs(chunk_z - last_z_chunk) <= RENDER_DISTANCE;
+}
+
+//a chunk the workers finished after the camera had left its range. it never enters chunks, so it
+//isn't drawn and no later boundary crossing has to find it to unload it
+void ChunkManager::drop_arrived_chunk(std::unique_ptr<Chunk> chunk) {
+	std::pair<int, int> coords(chunk->chunk_world_xposition, chunk->chunk_world_zposition);
+	chunks_to_load_list.erase(coords);
+	telemetry.chunk_cancelled(coords.first, coords.second);
+	if (mesh_cache.enabled) {
+		mesh_cache.store(*chunk);
+	}
+	chunk->state = CHUNK_EVICTING;
+	chunk_pool.release(std::move(chunk));
+	++chunks_dropped;
 }
 
 void ChunkManager::remove_unload_chunks() {
+	PROFILE_SCOPE("remove_unload_chunks");
 	int num_to_process = 2;
-	//remove all the chunks that were detected out of render distance
+	//remove all the chunks that were detected out of render distance. the camera may have come back
+	//since they were queued, so the distance is checked again
 	{
-		while (num_to_process > 0) {
-			std::lock_guard<std::mutex> lock(chunk_mutex);
-			if (!unload_list.empty()) {
-				chunks.erase(chunks.begin() + unload_list.front());
-				unload_list.pop();
+		while (num_to_process > 0 && !unload_list.empty()) {
+			std::pair<int, int> coords = unload_list.front();
+			unload_list.pop();
+			if (in_range(coords.first, coords.second)) {
+				continue;
+			}
+			std::unique_ptr<Chunk> unloaded = chunks.erase(coords.first, coords.second);
+			if (unloaded) {
+				staged_borders.erase(coords);
+				staged_borders_changed = true;
+				chunks_to_load_list.erase(coords);
+				telemetry.chunk_cancelled(coords.first, coords.second);
+				if (unloaded->state == CHUNK_RESIDENT) {
+					drop_resident(*unloaded);
+				}
+				else if (mesh_cache.enabled) {
+					mesh_cache.store(*unloaded);	//meshed but never uploaded, resident chunks handed theirs over already
+				}
+				unloaded->state = CHUNK_EVICTING;
+				if (backend) {
+					backend->release_chunk_resources(*unloaded);
+				}
+				chunk_pool.release(std::move(unloaded));
+				++chunks_unloaded;
 			}
 			num_to_process--;
 		}
@@ -141,6 +216,7 @@ void ChunkManager::remove_unload_chunks() {
 }
 
 void ChunkManager::update_visible_chunks(glm::vec3 position) {
+	PROFILE_SCOPE("update_visible_chunks");
 
 	generate_new_visible_chunks(position);
 	
@@ -154,123 +230,220 @@ void ChunkManager::configure_chunk_portal() {
 
 
 void ChunkManager::worker_loop() {
-	while (!stop_thread) {
-		std::pair<int, int> chunk_coords;
-
-		// Generate chunk outside the locked section
-		
+	PROFILE_THREAD("chunk worker");
+	while (true) {
+		ChunkTask task;
 
 		{
-			std::unique_lock<std::mutex> lock(chunk_mutex);
-			chunk_cv.wait(lock, [this] { return !pending_chunks.empty() || stop_thread; });
+			TimedLock lock(task_mutex, telemetry, LOCK_WORKER_TAKE_TASK);
+			task_cv.wait(lock.lock, [this] { return !tasks.empty() || stop_thread; });
+			lock.restart_hold();
 
 			if (stop_thread) break; // Exit if the manager is being destroyed
 
-			
+			auto next = std::min_element(tasks.begin(), tasks.end(), [this](const ChunkTask &a, const ChunkTask &b) {
+				return task_priority(a) < task_priority(b);
+			});
+			task = std::move(*next);
+			tasks.erase(next);
 		}
-		chunk_coords = pending_chunks.front();
-		pending_chunks.pop();
-		
-		
-		Chunk new_chunk(chunk_coords.first, chunk_coords.second);
-		
-		Generators::generate_poolroom(new_chunk);
-		Generators::carve_room(new_chunk);
-		new_chunk.generate_mesh();
 
-		rooms.push_back(new_chunk.room);
-		
-		{
-			std::lock_guard<std::mutex> lock(chunk_mutex);
-			total_verts += new_chunk.vertices.size();
-			//if chunk list isnt empty set the last chunk's next room to the newly created chunks room
-			if (!chunks.empty()) {
-				chunks.back().prev_room = rooms.back(); //this needs to be changed to the variable next_room
-				//chunks.back().configure_portal();
-			}
-			chunks.emplace_back(std::move(new_chunk));
-			
-		}
+		// Generate chunk outside the locked section
+		run_task(task);
 	}
 }
 
-void ChunkManager::generate_new_chunk(Chunk &chunk) {
-	//chunk.remove_heights();
-	//chunk.create_mesh();
+//lower runs first. chunks nearer the camera win, and at the same distance a chunk that is further along
+//the pipeline goes before starting a new one so finished chunks show up as early as possible
+int ChunkManager::task_priority(const ChunkTask &task) const {
+	int distance = std::max(std::abs(task.chunk_x - focus_x), std::abs(task.chunk_z - focus_z));
+	return distance * 3 + (STAGE_MESH - task.stage);
 }
 
-void ChunkManager::clear_unload_list() {
-	//unload_list.clear();
-}
-
-void ChunkManager::generate_chunks() {
-	for (int i = 0; i < ChunkManager::chunks.size(); ++i) {
-		//ChunkManager::chunks[i].remove_heights();
-		//ChunkManager::chunks[i].create_mesh();
+void ChunkManager::queue_task(ChunkTask task) {
+	{
+		TimedLock lock(task_mutex, telemetry, LOCK_WORKER_QUEUE_TASK);
+		tasks.push_back(std::move(task));
 	}
+	task_cv.notify_one();
 }
 
-void ChunkManager::render_chunks() {
-	
-	glEnable(GL_DEPTH_TEST);  // Ensure depth testing is on
-	//glEnable(GL_CULL_FACE);   // Cull back faces for performance
-	//glCullFace(GL_BACK);
-	std::lock_guard<std::mutex> lock(chunk_mutex);
-	for (int i = 0; i < ChunkManager::chunks.size(); ++i) {
-		
-		if (!chunks[i].buffers_initialized) {
-			std::cerr << "Warning: Chunk at (" << chunks[i].chunk_world_xposition
-				<< ", " << chunks[i].chunk_world_zposition
-				<< ") has uninitialized buffers!" << std::endl;
-			continue;
+void ChunkManager::run_task(ChunkTask &task) {
+	switch (task.stage) {
+	case STAGE_FILL: {
+		PROFILE_SCOPE("chunk fill");
+		task.chunk = chunk_pool.acquire(task.chunk_x, task.chunk_z);
+		if (regions.load(task.chunk_x, task.chunk_z, *task.chunk)) {
+			//saved after carving, so it only needs a mesh
+			task.chunk->state = CHUNK_GENERATED;
+			task.stage = STAGE_MESH;
+		}
+		else {
+			ChunkRng rng(world_seed, task.chunk_x, task.chunk_z, ChunkRng::STREAM_ROOM);
+			Generators::generate_poolroom(*task.chunk, rng);
+			task.stage = STAGE_CARVE;
 		}
+		queue_task(std::move(task));
+		break;
+	}
 
-		if (chunks[i].indices.empty()) {
-			std::cerr << "Warning: Chunk at (" << chunks[i].chunk_world_xposition
-				<< ", " << chunks[i].chunk_world_zposition
-				<< ") has no indices!" << std::endl;
-			continue;
+	case STAGE_CARVE: {
+		PROFILE_SCOPE("chunk carve");
+		{
+			ChunkRng rng(world_seed, task.chunk_x, task.chunk_z, ChunkRng::STREAM_STRUCTURES);
+			Generators::carve_room(*task.chunk, rng);
 		}
+		regions.save(*task.chunk);
+		task.chunk->state = CHUNK_GENERATED;
+		task.stage = STAGE_MESH;
+		queue_task(std::move(task));
+		break;
+	}
 
-		if (chunks[i].normals.empty()) {
-			std::cerr << "Warning: Chunk at (" << chunks[i].chunk_world_xposition
-				<< ", " << chunks[i].chunk_world_zposition
-				<< ") has no normals!" << std::endl;
-			continue;
+	case STAGE_MESH: {
+		//one set of border copies per worker, reused for every chunk it meshes
+		static thread_local ChunkBorders borders;
+		{
+			PROFILE_SCOPE("gather borders");
+			std::shared_ptr<const BorderSnapshot> snapshot;
+			{
+				TimedLock lock(border_mutex, telemetry, LOCK_WORKER_BORDERS);
+				snapshot = published_borders;
+			}
+			gather_borders(*snapshot, task.chunk_x, task.chunk_z, borders);
+		}
+		{
+			PROFILE_SCOPE("chunk mesh");
+			MeshingMode mode = meshing_mode;
+			auto mesh_start = std::chrono::steady_clock::now();
+			uint64_t key = mesh_cache.enabled ? MeshCache::mesh_key(*task.chunk, mode, borders) : 0;
+			if (!key || !mesh_cache.fetch(*task.chunk, key)) {
+				task.chunk->generate_mesh(mode, borders);
+				task.chunk->mesh_key = key;
+			}
+			task.chunk->compute_mesh_bounds();
+			//the blocks don't change after this, so the sides its neighbours mesh against are taken once
+			std::shared_ptr<ChunkBorders> sides = std::make_shared<ChunkBorders>();
+			for (int face = FACE_FRONT; face <= FACE_RIGHT; ++face) {
+				task.chunk->get_border((CubeFace)face, sides->sides[face]);
+			}
+			task.chunk->sides = std::move(sides);
+			task.chunk->mesh_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mesh_start).count();
+			task.chunk->state = CHUNK_MESHED;
 		}
 
-		if (chunks[i].vertices.empty()) {
-			std::cerr << "Warning: Chunk at (" << chunks[i].chunk_world_xposition
-				<< ", " << chunks[i].chunk_world_zposition
-				<< ") has no vertices!" << std::endl;
-			continue;
+		{
+			TimedLock lock(task_mutex, telemetry, LOCK_WORKER_FINISH);
+			--tasks_in_flight;
 		}
+		//blocks while the main thread is MAX_QUEUE_SIZE chunks behind, fails only when shutting down
+		PROFILE_SCOPE("ready_chunks push");
+		ready_chunks.push(std::move(task.chunk));
+		break;
+	}
+	}
+}
 
-		if (chunks[i].tangents.empty()) {
-			std::cerr << "Warning: Chunk at (" << chunks[i].chunk_world_xposition
-				<< ", " << chunks[i].chunk_world_zposition
-				<< ") has no tangents!" << std::endl;
-			continue;
+//copies the touching sides of the neighbours in snapshot of the chunk at chunk_x, chunk_z into borders,
+//reusing its storage
+void ChunkManager::gather_borders(const BorderSnapshot &snapshot, int chunk_x, int chunk_z, ChunkBorders &borders) {
+	const std::pair<int, int> offsets[4] = { { 0, 1 },{ 0, -1 },{ -1, 0 },{ 1, 0 } };	//indexed by CubeFace
+	for (int face = FACE_FRONT; face <= FACE_RIGHT; ++face) {
+		auto found = snapshot.find({ chunk_x + offsets[face].first, chunk_z + offsets[face].second });
+		if (found != snapshot.end() && found->second) {
+			//the neighbour's side facing back at this chunk
+			borders.sides[face] = found->second->sides[face ^ 1];
 		}
-		
-		if (chunks[i].buffers_generated && chunks[i].buffers_initialized && !chunks[i].indices.empty()) {
-			
-			glBindVertexArray(chunks[i].VertexArrayID);
-			glDrawElements(GL_TRIANGLES, chunks[i].indices.size(), GL_UNSIGNED_INT, 0);
+		else {
+			borders.sides[face].clear();
 		}
-		 // Starting from vertex 0; 3 vertices total -> 1 triangle
-		
 	}
+}
 
-	//glBindVertexArray(chunks[0].VertexArrayID);
-	//glDrawElements(GL_TRIANGLES, chunks[0].indices.size(), GL_UNSIGNED_INT, 0); // Starting from vertex 0; 3 vertices total -> 1 triangle
+//rebuilds the mesh of every loaded chunk with the current meshing mode, the new meshes get
+//uploaded into the existing buffers by the next Renderer::initChunkBuffers
+void ChunkManager::remesh_chunks() {
+	PROFILE_SCOPE("remesh_chunks");
+	total_verts = 0;
+	ChunkBorders borders;
+	for (Chunk &c : chunks) {
+		if (c.state == CHUNK_RESIDENT) {
+			drop_resident(c);
+		}
+		gather_borders(staged_borders, c.chunk_world_xposition, c.chunk_world_zposition, borders);
+		c.generate_mesh(meshing_mode, borders);
+		c.mesh_key = mesh_cache.enabled ? MeshCache::mesh_key(c, meshing_mode, borders) : 0;
+		c.compute_mesh_bounds();
+		c.state = CHUNK_MESHED;
+		total_verts += c.vertices.size();
+	}
+}
+
+void ChunkManager::generate_new_chunk(Chunk & /*chunk*/) {
+	//chunk.remove_heights();
+	//chunk.create_mesh();
+}
+
+void ChunkManager::clear_unload_list() {
+	//unload_list.clear();
+}
+
+void ChunkManager::generate_chunks() {
+	for ([[maybe_unused]] Chunk &c : chunks) {
+		//c.remove_heights();
+		//c.create_mesh();
+	}
+}
 
+//called by the renderer once a chunk's mesh is on the GPU. the CPU mesh is freed, or goes to the mesh cache
+//when that is on, and only the index count stays with the chunk
+void ChunkManager::make_resident(Chunk &chunk) {
+	chunk.index_count = (uint32_t)chunk.indices.size();
+	if (mesh_cache.enabled) {
+		mesh_cache.store(chunk);
+	}
+	else {
+		chunk.release_mesh();
+	}
+	chunk.resident_index = (int)resident.size();
+	resident.push_back(&chunk);
+	chunk.state = CHUNK_RESIDENT;
+	telemetry.chunk_resident(chunk.chunk_world_xposition, chunk.chunk_world_zposition);
+}
+
+//takes the chunk out of the resident list, its state is left to the caller
+void ChunkManager::drop_resident(Chunk &chunk) {
+	Chunk *last = resident.back();
+	resident[chunk.resident_index] = last;
+	last->resident_index = chunk.resident_index;
+	resident.pop_back();
+	chunk.resident_index = -1;
+}
+
+//samples the queue depths into the telemetry, call once a frame from the main thread
+void ChunkManager::update_telemetry(float delta_time) {
+	size_t depths[QUEUE_COUNT];
+	depths[QUEUE_TO_LOAD] = chunks_to_load.size();
+	depths[QUEUE_UNLOAD] = unload_list.size();
+	depths[QUEUE_READY] = ready_chunks.size();
+	{
+		TimedLock lock(task_mutex, telemetry, LOCK_SAMPLE_DEPTHS);
+		depths[QUEUE_TASKS] = tasks.size();
+		depths[QUEUE_IN_FLIGHT] = tasks_in_flight;
+	}
+	telemetry.update(delta_time, depths);
 }
 
 ChunkManager::~ChunkManager() {
-	stop_thread = true;
-	chunk_cv.notify_one(); // Wake up thread to exit
-	if (worker_thread.joinable()) {
-		worker_thread.join();
+	{
+		std::lock_guard<std::mutex> lock(task_mutex);
+		stop_thread = true;
+	}
+	task_cv.notify_all(); // Wake up every worker to exit
+	ready_chunks.close(); // including any blocked handing over a finished chunk
+	for (std::thread &worker : worker_threads) {
+		if (worker.joinable()) {
+			worker.join();
+		}
 	}
 }
\ No newline at end of file
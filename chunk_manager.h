@@ -6,17 +6,39 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include "glad/glad.h"
+#include <atomic>
+#include <memory>
 #include "chunk.h"
 #include "generators.h"
+#include "bounded_queue.h"
+#include "chunk_registry.h"
+#include "chunk_pool.h"
+#include "region_file.h"
+#include "mesh_cache.h"
+#include "chunk_backend.h"
+#include "profiler.h"
+#include "chunk_telemetry.h"
 #include <algorithm>
 #include <unordered_set>
+#include <unordered_map>
+
+//stages a chunk goes through on the worker pool, each stage runs as its own task so a far away chunk
+//can't hold a worker while a closer one is waiting
+enum ChunkStage {
+	STAGE_FILL,		//construct the chunk's blocks and pick its room
+	STAGE_CARVE,	//carve the room and the structures inside it
+	STAGE_MESH		//mesh against the loaded neighbours and hand the chunk to the main thread
+};
+
+//the sides of every chunk in ChunkManager::chunks by coordinates, what STAGE_MESH meshes a new chunk against.
+//a published snapshot is never modified, workers keep it alive for as long as they read it
+using BorderSnapshot = std::unordered_map<std::pair<int, int>, std::shared_ptr<const ChunkBorders>, PairHash>;
 
-// Hash function for unordered_set<pair<int, int>>
-struct PairHash {
-	std::size_t operator()(const std::pair<int, int>& p) const {
-		return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
-	}
+struct ChunkTask {
+	int chunk_x;
+	int chunk_z;
+	ChunkStage stage;
+	std::unique_ptr<Chunk> chunk;	//created by STAGE_FILL
 };
 
 class ChunkManager {
@@ -33,23 +55,57 @@ public:
 	int total_verts;
 
 	static constexpr size_t MAX_QUEUE_SIZE = 100;
+	static constexpr uint64_t DEFAULT_WORLD_SEED = 1;
+
+	// Every chunk's rooms and structures and the terrain noise are derived from this, see ChunkRng
+	uint64_t world_seed = DEFAULT_WORLD_SEED;
 
 	// Threading
-	std::thread worker_thread;
-	std::mutex chunk_mutex;
-	std::condition_variable chunk_cv;
+	// chunks and rooms belong to the main thread, workers never read them. they mesh against the
+	// published BorderSnapshot instead, which the main thread swaps for a new one at most once a frame,
+	// so taking that pointer is all the two sides synchronize on besides the task and ready queues.
+	// a finished chunk is owned by exactly one side at a time: the task on a worker, then ready_chunks,
+	// then the main thread
+	int worker_count;
+	std::vector<std::thread> worker_threads;
+	std::mutex task_mutex;					//guards tasks and stop_thread
+	std::mutex border_mutex;				//guards published_borders, the pointer only
+	std::condition_variable task_cv;
+	std::vector<ChunkTask> tasks;
+	size_t tasks_in_flight = 0;				//chunks between STAGE_FILL and ready_chunks, at most MAX_QUEUE_SIZE
+	BoundedQueue<std::unique_ptr<Chunk>> ready_chunks{ MAX_QUEUE_SIZE };
 	bool stop_thread = false;
 
-	std::vector<Chunk> chunks;
+	// Chunk the camera is in, workers pick the tasks closest to it first
+	std::atomic<int> focus_x{ 0 };
+	std::atomic<int> focus_z{ 0 };
+
+	// Meshing, read by the worker for every new chunk and switchable from the editor
+	std::atomic<MeshingMode> meshing_mode{ MESH_GREEDY };
+
+	ChunkPool chunk_pool{ MAX_QUEUE_SIZE };	//unloaded chunks waiting to be reused by STAGE_FILL
+	ChunkRegistry chunks;
+	RegionStore regions;					//chunks generated before, STAGE_FILL loads from here first
+	MeshCache mesh_cache;					//meshes of uploaded chunks, STAGE_MESH reuses them when nothing changed. off by default
+	ChunkTelemetry telemetry;				//lock waits, queue depths and request to resident latency
+	std::vector<Chunk *> resident;			//chunks in CHUNK_RESIDENT, the only ones the renderer draws
+	ChunkBackend *backend = nullptr;		//holds the chunks' GPU resources, none when running headless
 	std::vector<Room> rooms;
-	std::queue<int> unload_list;
-	std::queue<Chunk> pending_ready_chunks;
+	std::queue<std::pair<int, int>> unload_list;	//chunk coordinates, re-checked before unloading
 	std::queue<std::pair<int, int>> chunks_to_load;
 	std::unordered_set<std::pair<int, int>, PairHash> chunks_to_load_list;
-	std::queue<std::pair<int, int>> pending_chunks;
 	std::vector<int> load_list_index;
-
-	ChunkManager(glm::vec3 position);
+	BorderSnapshot staged_borders;			//main thread's copy, follows chunks and is published when it changed
+	bool staged_borders_changed = false;
+	std::shared_ptr<const BorderSnapshot> published_borders = std::make_shared<const BorderSnapshot>();
+	size_t border_publishes = 0;
+	size_t chunks_unloaded = 0;				//erased from chunks once out of range
+	size_t chunks_dropped = 0;				//finished by the workers after the camera had left their range, never inserted
+
+	//region_root is where the region files of every seed and generator version go, empty (the default) to
+	//generate every chunk from scratch
+	ChunkManager(glm::vec3 position, int workers = default_worker_count(), uint64_t seed = DEFAULT_WORLD_SEED,
+		const std::string &region_root = "");
 	ChunkManager() = default;
 	~ChunkManager();
 
@@ -57,18 +113,29 @@ public:
 	void update_visible_chunks(glm::vec3 position);
 	void generate_new_visible_chunks(glm::vec3 position);
 	void generate_new_chunk(Chunk &chunk);
-	void generate_chunk_buffers();
 	void clear_unload_list();
 
 	void add_pending_chunks();
 	void remove_unload_chunks();
+	bool in_range(int chunk_x, int chunk_z) const;
+	void drop_arrived_chunk(std::unique_ptr<Chunk> chunk);
 	void fill_chunks();
 	void generate_chunks();
-	void render_chunks();
+	void make_resident(Chunk &chunk);
+	void drop_resident(Chunk &chunk);
+	void update_telemetry(float delta_time);
+
+	void publish_borders();
+	static void gather_borders(const BorderSnapshot &snapshot, int chunk_x, int chunk_z, ChunkBorders &borders);
+	void remesh_chunks();
 
 	//void configure_chunk_portals();
 
+	static int default_worker_count();
 	void worker_loop(); // Background thread function
+	void run_task(ChunkTask &task);
+	void queue_task(ChunkTask task);
+	int task_priority(const ChunkTask &task) const;
 
 	
 };
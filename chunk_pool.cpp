@@ -0,0 +1,60 @@
+#include "chunk_pool.h"
+
+ChunkPool::ChunkPool(size_t capacity) : capacity(capacity) {
+	free_chunks.reserve(capacity);
+}
+
+std::unique_ptr<Chunk> ChunkPool::acquire(int chunk_x, int chunk_z) {
+	std::unique_ptr<Chunk> chunk;
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		if (!free_chunks.empty()) {
+			chunk = std::move(free_chunks.back());
+			free_chunks.pop_back();
+		}
+	}
+
+	if (chunk) {
+		chunk->reset(chunk_x, chunk_z);
+		++chunk_reuses;
+	}
+	else {
+		chunk = std::make_unique<Chunk>(chunk_x, chunk_z);
+		++chunk_allocations;
+	}
+	return chunk;
+}
+
+void ChunkPool::release(std::unique_ptr<Chunk> chunk) {
+	if (!chunk) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		if (free_chunks.size() < capacity) {
+			free_chunks.push_back(std::move(chunk));
+			return;
+		}
+	}
+
+	++chunk_frees;
+	chunk.reset();
+}
+
+size_t ChunkPool::pooled() {
+	std::lock_guard<std::mutex> lock(pool_mutex);
+	return free_chunks.size();
+}
+
+void ChunkPool::update(float delta_time) {
+	rate_timer += delta_time;
+	if (rate_timer < 1.0f) {
+		return;
+	}
+
+	size_t allocations = chunk_allocations;
+	allocations_per_second = (allocations - last_allocations) / rate_timer;
+	last_allocations = allocations;
+	rate_timer = 0.0f;
+}
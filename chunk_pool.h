@@ -0,0 +1,47 @@
+#ifndef CHUNK_POOL_H
+#define CHUNK_POOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "chunk.h"
+
+//keeps unloaded chunks around so the next chunk to load can reuse their block and mesh storage instead of
+//allocating new ones. once the pool holds as many chunks as a walk unloads between loads, streaming in a
+//straight line reaches a steady state with no chunk allocations
+class ChunkPool {
+
+public:
+
+	ChunkPool(size_t capacity);
+	~ChunkPool() = default;
+
+	//a chunk reset to the given coordinates, recycled when one is available. safe to call from the workers
+	std::unique_ptr<Chunk> acquire(int chunk_x, int chunk_z);
+	//returns an unloaded chunk to the pool, or frees it if the pool is full
+	void release(std::unique_ptr<Chunk> chunk);
+	size_t pooled();
+
+	//recomputes the per second rates, call once a frame from the main thread
+	void update(float delta_time);
+
+	//running totals since startup
+	std::atomic<size_t> chunk_allocations{ 0 };		//new Chunk objects
+	std::atomic<size_t> chunk_reuses{ 0 };			//chunks handed out again from the pool
+	std::atomic<size_t> chunk_frees{ 0 };			//chunks dropped because the pool was full
+
+	//rates over the last second
+	float allocations_per_second = 0.0f;
+
+private:
+
+	std::mutex pool_mutex;
+	std::vector<std::unique_ptr<Chunk>> free_chunks;
+	size_t capacity;
+
+	float rate_timer = 0.0f;
+	size_t last_allocations = 0;
+};
+
+#endif // !CHUNK_POOL_H
@@ -0,0 +1,65 @@
+#include "chunk_registry.h"
+
+Chunk *ChunkRegistry::find(int chunk_x, int chunk_z) {
+	int slot = find_slot(chunk_x, chunk_z);
+	return slot < 0 ? nullptr : slots[slot].get();
+}
+
+int ChunkRegistry::find_slot(int chunk_x, int chunk_z) const {
+	auto it = index.find({ chunk_x, chunk_z });
+	return it == index.end() ? -1 : it->second;
+}
+
+//the chunk on the other side of the given horizontal face, nullptr if it isn't loaded
+Chunk *ChunkRegistry::neighbour(const Chunk &chunk, CubeFace face) {
+	int x = chunk.chunk_world_xposition;
+	int z = chunk.chunk_world_zposition;
+	switch (face) {
+	case FACE_FRONT: return find(x, z + 1);
+	case FACE_BACK:  return find(x, z - 1);
+	case FACE_LEFT:  return find(x - 1, z);
+	case FACE_RIGHT: return find(x + 1, z);
+	default:         return nullptr;
+	}
+}
+
+//stores the chunk in a free slot (or a new one) and returns the slot. a chunk already registered at the
+//same coordinates is replaced
+int ChunkRegistry::insert(std::unique_ptr<Chunk> chunk) {
+	std::pair<int, int> coords = { chunk->chunk_world_xposition, chunk->chunk_world_zposition };
+	int slot = find_slot(coords.first, coords.second);
+
+	if (slot < 0) {
+		if (!free_slots.empty()) {
+			slot = free_slots.back();
+			free_slots.pop_back();
+		}
+		else {
+			slot = (int)slots.size();
+			slots.emplace_back();
+		}
+	}
+
+	slots[slot] = std::move(chunk);
+	index[coords] = slot;
+	last_inserted = slot;
+	return slot;
+}
+
+//takes the chunk out of the registry and hands its slot to the free list. the chunk is returned so the
+//caller can recycle it, nullptr if nothing is loaded at those coordinates
+std::unique_ptr<Chunk> ChunkRegistry::erase(int chunk_x, int chunk_z) {
+	auto it = index.find({ chunk_x, chunk_z });
+	if (it == index.end()) {
+		return nullptr;
+	}
+
+	int slot = it->second;
+	std::unique_ptr<Chunk> chunk = std::move(slots[slot]);
+	free_slots.push_back(slot);
+	index.erase(it);
+	if (last_inserted == slot) {
+		last_inserted = -1;
+	}
+	return chunk;
+}
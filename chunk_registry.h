@@ -0,0 +1,64 @@
+#ifndef CHUNK_REGISTRY_H
+#define CHUNK_REGISTRY_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "chunk.h"
+
+// Hash function for unordered_set<pair<int, int>>
+struct PairHash {
+	std::size_t operator()(const std::pair<int, int>& p) const {
+		return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
+	}
+};
+
+//loaded chunks stored in fixed slots and indexed by chunk coordinates. erasing a chunk frees its slot for
+//the next insert instead of shifting the others, so slot numbers and Chunk references stay valid until
+//that chunk itself is erased. chunks are owned through unique_ptr so they move in and out (to the
+//ChunkPool) without copying their storage
+class ChunkRegistry {
+
+public:
+
+	//walks the occupied slots in slot order
+	class iterator {
+	public:
+		iterator(ChunkRegistry *registry, int slot) : registry(registry), slot(slot) { skip_free(); }
+		Chunk &operator*() const { return *registry->slots[slot]; }
+		Chunk *operator->() const { return registry->slots[slot].get(); }
+		iterator &operator++() { ++slot; skip_free(); return *this; }
+		bool operator!=(const iterator &other) const { return slot != other.slot; }
+		bool operator==(const iterator &other) const { return slot == other.slot; }
+	private:
+		void skip_free() {
+			while (slot < (int)registry->slots.size() && !registry->slots[slot]) ++slot;
+		}
+		ChunkRegistry *registry;
+		int slot;
+	};
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, (int)slots.size()); }
+
+	Chunk *find(int chunk_x, int chunk_z);
+	Chunk *neighbour(const Chunk &chunk, CubeFace face);
+	int find_slot(int chunk_x, int chunk_z) const;
+	Chunk &at_slot(int slot) { return *slots[slot]; }
+
+	int insert(std::unique_ptr<Chunk> chunk);
+	std::unique_ptr<Chunk> erase(int chunk_x, int chunk_z);
+
+	size_t size() const { return index.size(); }
+	bool empty() const { return index.empty(); }
+
+	int last_inserted = -1;		//slot of the most recently inserted chunk, -1 if it has been erased
+
+private:
+
+	std::vector<std::unique_ptr<Chunk>> slots;	//null for a free slot
+	std::vector<int> free_slots;
+	std::unordered_map<std::pair<int, int>, int, PairHash> index;
+};
+
+#endif // !CHUNK_REGISTRY_H
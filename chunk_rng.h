@@ -0,0 +1,47 @@
+#ifndef CHUNK_RNG_H
+#define CHUNK_RNG_H
+
+#include <cstdint>
+
+//counter based random numbers for one chunk. the stream is a hash of the world seed, the chunk's coordinates
+//and what the numbers are for, so a chunk generates the same way on every run and on whichever worker
+//picks it up, without any state shared between threads
+class ChunkRng {
+
+public:
+
+	//one stream per generation step so a step's numbers don't depend on how many an earlier one used
+	enum Stream {
+		STREAM_ROOM,		//generate_poolroom
+		STREAM_STRUCTURES	//carve_room
+	};
+
+	ChunkRng(uint64_t world_seed, int chunk_x, int chunk_z, Stream stream) {
+		uint64_t coords = ((uint64_t)(uint32_t)chunk_x << 32) | (uint32_t)chunk_z;
+		key = mix(world_seed ^ mix(coords) ^ mix(0x100000000ull + stream));
+	}
+
+	uint32_t next() {
+		return (uint32_t)(mix(key + counter++ * 0x9E3779B97F4A7C15ull) >> 32);
+	}
+
+	//uniform in [0, n), n must be positive. a drop in replacement for rand() % n
+	int range(int n) {
+		return (int)(next() % (uint32_t)n);
+	}
+
+	//splitmix64 finaliser
+	static uint64_t mix(uint64_t z) {
+		z += 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+private:
+
+	uint64_t key;
+	uint64_t counter = 0;
+};
+
+#endif // !CHUNK_RNG_H
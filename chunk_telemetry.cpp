@@ -0,0 +1,157 @@
+#include "chunk_telemetry.h"
+#include <algorithm>
+
+const char *ChunkTelemetry::lock_site_name(LockSite site) {
+	static const char *names[LOCK_SITE_COUNT] = {
+		"main: add pending tasks",
+		"main: publish borders",
+		"main: sample queue depths",
+		"worker: take task",
+		"worker: queue task",
+		"worker: take border snapshot",
+		"worker: finish chunk"
+	};
+	return names[site];
+}
+
+const char *ChunkTelemetry::queue_name(ChunkQueue queue) {
+	static const char *names[QUEUE_COUNT] = { "chunks_to_load", "tasks", "tasks_in_flight", "ready_chunks", "unload_list" };
+	return names[queue];
+}
+
+ChunkTelemetry::ChunkTelemetry() {
+	for (std::vector<float> &history : depths) {
+		history.assign(HISTORY_SAMPLES, 0.0f);
+	}
+	latencies.reserve(LATENCY_SAMPLES);
+}
+
+static void store_max(std::atomic<int64_t> &max, int64_t value) {
+	int64_t current = max.load(std::memory_order_relaxed);
+	while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+void ChunkTelemetry::record_lock(LockSite site, int64_t wait_ns, int64_t hold_ns, bool contended) {
+	LockSiteCounters &counters = sites[site];
+	counters.acquisitions.fetch_add(1, std::memory_order_relaxed);
+	if (contended) {
+		counters.contended.fetch_add(1, std::memory_order_relaxed);
+		counters.wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+		store_max(counters.max_wait_ns, wait_ns);
+	}
+	counters.hold_ns.fetch_add(hold_ns, std::memory_order_relaxed);
+	store_max(counters.max_hold_ns, hold_ns);
+}
+
+void ChunkTelemetry::chunk_requested(int chunk_x, int chunk_z) {
+	requests[{ chunk_x, chunk_z }] = std::chrono::steady_clock::now();
+}
+
+void ChunkTelemetry::chunk_resident(int chunk_x, int chunk_z) {
+	auto found = requests.find({ chunk_x, chunk_z });
+	if (found == requests.end()) {
+		return;		//remeshed, not requested
+	}
+	float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - found->second).count();
+	requests.erase(found);
+	if (latencies.size() < LATENCY_SAMPLES) {
+		latencies.push_back(ms);
+	}
+	else {
+		latencies[latency_count % LATENCY_SAMPLES] = ms;
+	}
+	++latency_count;
+}
+
+void ChunkTelemetry::chunk_cancelled(int chunk_x, int chunk_z) {
+	requests.erase({ chunk_x, chunk_z });
+}
+
+void ChunkTelemetry::update(float delta_time, const size_t (&queue_depths)[QUEUE_COUNT]) {
+	for (int q = 0; q < QUEUE_COUNT; ++q) {
+		depths[q][history_position] = (float)queue_depths[q];
+		max_depths[q] = std::max(max_depths[q], queue_depths[q]);
+	}
+	history_position = (history_position + 1) % HISTORY_SAMPLES;
+
+	rate_timer += delta_time;
+	if (rate_timer < 1.0f) {
+		return;
+	}
+	for (LockSiteCounters &counters : sites) {
+		int64_t wait_ns = counters.wait_ns.load(std::memory_order_relaxed);
+		int64_t hold_ns = counters.hold_ns.load(std::memory_order_relaxed);
+		counters.wait_ms_per_second = (wait_ns - counters.last_wait_ns) / 1e6f / rate_timer;
+		counters.hold_ms_per_second = (hold_ns - counters.last_hold_ns) / 1e6f / rate_timer;
+		counters.last_wait_ns = wait_ns;
+		counters.last_hold_ns = hold_ns;
+	}
+	rate_timer = 0.0f;
+}
+
+std::vector<LockSiteStats> ChunkTelemetry::lock_sites() const {
+	std::vector<LockSiteStats> stats;
+	stats.reserve(LOCK_SITE_COUNT);
+	for (int s = 0; s < LOCK_SITE_COUNT; ++s) {
+		const LockSiteCounters &counters = sites[s];
+		stats.push_back({ lock_site_name((LockSite)s),
+			(size_t)counters.acquisitions.load(std::memory_order_relaxed),
+			(size_t)counters.contended.load(std::memory_order_relaxed),
+			counters.wait_ns.load(std::memory_order_relaxed) / 1e6,
+			counters.hold_ns.load(std::memory_order_relaxed) / 1e6,
+			counters.max_wait_ns.load(std::memory_order_relaxed) / 1e6f,
+			counters.max_hold_ns.load(std::memory_order_relaxed) / 1e6f,
+			counters.wait_ms_per_second,
+			counters.hold_ms_per_second });
+	}
+	return stats;
+}
+
+ChunkLatencyStats ChunkTelemetry::latency() const {
+	ChunkLatencyStats stats = { latency_count, 0.0f, 0.0f, 0.0f, 0.0f };
+	if (latencies.empty()) {
+		return stats;
+	}
+	std::vector<float> sorted = latencies;
+	std::sort(sorted.begin(), sorted.end());
+	auto at = [&sorted](float fraction) { return sorted[std::min(sorted.size() - 1, (size_t)(fraction * (sorted.size() - 1) + 0.5f))]; };
+	stats.p50_ms = at(0.5f);
+	stats.p90_ms = at(0.9f);
+	stats.p99_ms = at(0.99f);
+	stats.max_ms = sorted.back();
+	return stats;
+}
+
+void ChunkTelemetry::reset_maxima() {
+	for (size_t &max : max_depths) {
+		max = 0;
+	}
+	for (LockSiteCounters &counters : sites) {
+		counters.max_wait_ns = 0;
+		counters.max_hold_ns = 0;
+	}
+}
+
+//an uncontended lock costs one try_lock and two clock reads, the wait is only timed when there is one
+TimedLock::TimedLock(std::mutex &mutex, ChunkTelemetry &telemetry, LockSite site)
+	: lock(mutex, std::try_to_lock), telemetry(telemetry), site(site) {
+	if (!lock.owns_lock()) {
+		contended = true;
+		auto start = std::chrono::steady_clock::now();
+		lock.lock();
+		acquired = std::chrono::steady_clock::now();
+		wait_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(acquired - start).count();
+	}
+	else {
+		acquired = std::chrono::steady_clock::now();
+	}
+}
+
+TimedLock::~TimedLock() {
+	int64_t hold_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - acquired).count();
+	if (lock.owns_lock()) {
+		lock.unlock();
+	}
+	telemetry.record_lock(site, wait_ns, hold_ns, contended);
+}
@@ -0,0 +1,139 @@
+#ifndef CHUNK_TELEMETRY_H
+#define CHUNK_TELEMETRY_H
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include "chunk_registry.h"
+
+//every place ChunkManager's mutexes are taken, each timed on its own
+enum LockSite {
+	LOCK_ADD_PENDING_TASKS,		//task_mutex, main thread handing requests to the workers
+	LOCK_PUBLISH_BORDERS,		//border_mutex, main thread swapping in a new BorderSnapshot
+	LOCK_SAMPLE_DEPTHS,			//task_mutex, main thread reading the queue depths for the telemetry
+	LOCK_WORKER_TAKE_TASK,		//task_mutex, worker picking its next task, not counting the wait for one
+	LOCK_WORKER_QUEUE_TASK,		//task_mutex, worker queueing a chunk's next stage
+	LOCK_WORKER_BORDERS,		//border_mutex, worker taking the published BorderSnapshot
+	LOCK_WORKER_FINISH,			//task_mutex, worker counting a finished chunk out of tasks_in_flight
+	LOCK_SITE_COUNT
+};
+
+//the queues a chunk passes through between its request and ChunkManager::chunks
+enum ChunkQueue {
+	QUEUE_TO_LOAD,		//chunks_to_load, requested and waiting for an in flight slot
+	QUEUE_TASKS,		//tasks waiting for a worker, any stage
+	QUEUE_IN_FLIGHT,	//tasks_in_flight, between STAGE_FILL and ready_chunks, at most MAX_QUEUE_SIZE
+	QUEUE_READY,		//ready_chunks, meshed and waiting for add_pending_chunks
+	QUEUE_UNLOAD,		//unload_list
+	QUEUE_COUNT
+};
+
+//a lock site's totals since startup, plus the time waited and held over the last second
+struct LockSiteStats {
+	const char *name;
+	size_t acquisitions;
+	size_t contended;				//acquisitions that found the mutex taken and had to wait
+	double wait_ms;
+	double hold_ms;
+	float max_wait_ms;
+	float max_hold_ms;
+	float wait_ms_per_second;		//over the last second, 1000 would be waiting the whole time
+	float hold_ms_per_second;
+};
+
+//request to CHUNK_RESIDENT times of the last LATENCY_SAMPLES chunks
+struct ChunkLatencyStats {
+	size_t count;		//samples since startup
+	float p50_ms, p90_ms, p99_ms, max_ms;
+};
+
+//where ChunkManager's threads wait on each other and how deep its queues get. lock sites are recorded
+//from any thread with atomics, the queue depths and latencies by the main thread. used to size the worker
+//pool and the queue limits, shown in the editor and by the bench
+class ChunkTelemetry {
+
+public:
+
+	static constexpr int HISTORY_SAMPLES = 240;		//queue depths, one sample a frame
+	static constexpr size_t LATENCY_SAMPLES = 1024;
+
+	static const char *lock_site_name(LockSite site);
+	static const char *queue_name(ChunkQueue queue);
+
+	ChunkTelemetry();
+
+	//called by TimedLock
+	void record_lock(LockSite site, int64_t wait_ns, int64_t hold_ns, bool contended);
+
+	//request and arrival of the chunk at chunk_x, chunk_z, main thread only. cancel drops a request
+	//whose chunk is unloaded before it becomes resident
+	void chunk_requested(int chunk_x, int chunk_z);
+	void chunk_resident(int chunk_x, int chunk_z);
+	void chunk_cancelled(int chunk_x, int chunk_z);
+
+	//records this frame's queue depths and, once a second, the per second lock rates. main thread once a frame
+	void update(float delta_time, const size_t (&queue_depths)[QUEUE_COUNT]);
+
+	std::vector<LockSiteStats> lock_sites() const;
+	ChunkLatencyStats latency() const;
+	//a queue's depth over the last HISTORY_SAMPLES frames, a ring whose oldest sample is at history_offset
+	const std::vector<float> &depth_history(ChunkQueue queue) const { return depths[queue]; }
+	int history_offset() const { return history_position; }
+	size_t max_depth(ChunkQueue queue) const { return max_depths[queue]; }
+	void reset_maxima();
+
+private:
+
+	struct LockSiteCounters {
+		std::atomic<uint64_t> acquisitions{ 0 };
+		std::atomic<uint64_t> contended{ 0 };
+		std::atomic<int64_t> wait_ns{ 0 };
+		std::atomic<int64_t> hold_ns{ 0 };
+		std::atomic<int64_t> max_wait_ns{ 0 };
+		std::atomic<int64_t> max_hold_ns{ 0 };
+		int64_t last_wait_ns = 0;		//totals at the last per second update, main thread
+		int64_t last_hold_ns = 0;
+		float wait_ms_per_second = 0.0f;
+		float hold_ms_per_second = 0.0f;
+	};
+
+	LockSiteCounters sites[LOCK_SITE_COUNT];
+	std::vector<float> depths[QUEUE_COUNT];
+	size_t max_depths[QUEUE_COUNT] = {};
+	int history_position = 0;
+	float rate_timer = 0.0f;
+
+	std::unordered_map<std::pair<int, int>, std::chrono::steady_clock::time_point, PairHash> requests;
+	std::vector<float> latencies;		//ring of LATENCY_SAMPLES
+	size_t latency_count = 0;
+};
+
+//a lock_guard that records how long it waited for the mutex and how long it held it. holds a unique_lock
+//so a condition_variable can wait on it, call restart_hold after such a wait so the time spent waiting
+//unlocked isn't counted as held
+class TimedLock {
+
+public:
+
+	TimedLock(std::mutex &mutex, ChunkTelemetry &telemetry, LockSite site);
+	~TimedLock();
+	TimedLock(const TimedLock &) = delete;
+	TimedLock &operator=(const TimedLock &) = delete;
+
+	void restart_hold() { acquired = std::chrono::steady_clock::now(); }
+
+	std::unique_lock<std::mutex> lock;
+
+private:
+
+	ChunkTelemetry &telemetry;
+	LockSite site;
+	bool contended = false;
+	int64_t wait_ns = 0;
+	std::chrono::steady_clock::time_point acquired;
+};
+
+#endif // !CHUNK_TELEMETRY_H
@@ -0,0 +1,84 @@
+#include "frustum.h"
+
+//sse2 is part of every x86-64 target, so there is no runtime check like the noise kernels need
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE2
+#include <emmintrin.h>
+#endif
+
+Frustum Frustum::from_matrix(const glm::mat4 &m) {
+	//glm is column major, row i of the matrix is m[0][i], m[1][i], m[2][i], m[3][i]
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	Frustum frustum;
+	frustum.planes[0] = row3 + row0;	//left
+	frustum.planes[1] = row3 - row0;	//right
+	frustum.planes[2] = row3 + row1;	//bottom
+	frustum.planes[3] = row3 - row1;	//top
+	frustum.planes[4] = row3 + row2;	//near
+	frustum.planes[5] = row3 - row2;	//far
+	return frustum;
+}
+
+//for each plane only two corners matter: the one furthest along its normal decides whether the box is
+//outside, the one furthest against it whether the box crosses the plane
+FrustumTest Frustum::test_box(const glm::vec3 &min, const glm::vec3 &max) const {
+	FrustumTest result = FRUSTUM_INSIDE;
+	for (const glm::vec4 &plane : planes) {
+		glm::vec3 far_corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+		glm::vec3 near_corner(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+		if (glm::dot(glm::vec3(plane), far_corner) + plane.w < 0.0f) {
+			return FRUSTUM_OUTSIDE;
+		}
+		if (glm::dot(glm::vec3(plane), near_corner) + plane.w < 0.0f) {
+			result = FRUSTUM_INTERSECTS;
+		}
+	}
+	return result;
+}
+
+void Frustum::test_boxes(const FrustumBoxes &boxes, FrustumTest *results) const {
+	int i = 0;
+#ifdef FRUSTUM_SSE2
+	//the corner choice only depends on the plane, so per plane it is a choice between the min and max arrays
+	const float *far_x[6], *far_y[6], *far_z[6], *near_x[6], *near_y[6], *near_z[6];
+	for (int p = 0; p < 6; ++p) {
+		const glm::vec4 &plane = planes[p];
+		far_x[p] = plane.x >= 0.0f ? boxes.max_x : boxes.min_x;
+		far_y[p] = plane.y >= 0.0f ? boxes.max_y : boxes.min_y;
+		far_z[p] = plane.z >= 0.0f ? boxes.max_z : boxes.min_z;
+		near_x[p] = plane.x >= 0.0f ? boxes.min_x : boxes.max_x;
+		near_y[p] = plane.y >= 0.0f ? boxes.min_y : boxes.max_y;
+		near_z[p] = plane.z >= 0.0f ? boxes.min_z : boxes.max_z;
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= boxes.count; i += 4) {
+		__m128 outside = zero;
+		__m128 crossing = zero;
+		for (int p = 0; p < 6; ++p) {
+			__m128 a = _mm_set1_ps(planes[p].x);
+			__m128 b = _mm_set1_ps(planes[p].y);
+			__m128 c = _mm_set1_ps(planes[p].z);
+			__m128 d = _mm_set1_ps(planes[p].w);
+			__m128 far_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(far_x[p] + i)), _mm_mul_ps(b, _mm_loadu_ps(far_y[p] + i))),
+				_mm_add_ps(_mm_mul_ps(c, _mm_loadu_ps(far_z[p] + i)), d));
+			__m128 near_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(near_x[p] + i)), _mm_mul_ps(b, _mm_loadu_ps(near_y[p] + i))),
+				_mm_add_ps(_mm_mul_ps(c, _mm_loadu_ps(near_z[p] + i)), d));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(far_distance, zero));
+			crossing = _mm_or_ps(crossing, _mm_cmplt_ps(near_distance, zero));
+		}
+		int outside_bits = _mm_movemask_ps(outside);
+		int crossing_bits = _mm_movemask_ps(crossing);
+		for (int j = 0; j < 4; ++j) {
+			results[i + j] = (outside_bits >> j) & 1 ? FRUSTUM_OUTSIDE : (crossing_bits >> j) & 1 ? FRUSTUM_INTERSECTS : FRUSTUM_INSIDE;
+		}
+	}
+#endif
+	for (; i < boxes.count; ++i) {
+		results[i] = test_box(glm::vec3(boxes.min_x[i], boxes.min_y[i], boxes.min_z[i]), glm::vec3(boxes.max_x[i], boxes.max_y[i], boxes.max_z[i]));
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+//where a box is relative to a frustum
+enum FrustumTest : uint8_t {
+	FRUSTUM_OUTSIDE,		//completely outside at least one plane
+	FRUSTUM_INTERSECTS,		//crosses a plane, may or may not overlap the frustum itself
+	FRUSTUM_INSIDE			//inside all six planes
+};
+
+//axis aligned boxes laid out one array per coordinate so four of them are tested against a plane at once
+struct FrustumBoxes {
+	const float *min_x, *min_y, *min_z;
+	const float *max_x, *max_y, *max_z;
+	int count;
+};
+
+//the six planes of a view projection matrix, pointing inwards. a point p is inside plane i when
+//dot(planes[i], vec4(p, 1)) >= 0. planes aren't normalized, only the sign of the distance is used
+struct Frustum {
+
+	glm::vec4 planes[6];
+
+	//extracts the planes of an OpenGL clip space (-w <= x, y, z <= w) matrix such as projection * view
+	static Frustum from_matrix(const glm::mat4 &view_projection);
+
+	FrustumTest test_box(const glm::vec3 &min, const glm::vec3 &max) const;
+	//writes the FrustumTest of every box to results, with SSE2 where the compiler targets it
+	void test_boxes(const FrustumBoxes &boxes, FrustumTest *results) const;
+};
+
+#endif // !FRUSTUM_H
@@ -2,18 +2,18 @@
 
 #include "generators.h"
 
-void Generators::generate_poolroom(Chunk &chunk) {
+void Generators::generate_poolroom(Chunk &chunk, ChunkRng &rng) {
 	int maxWidth = (chunk.CHUNK_SIZE - 1) / 2;
 	int maxDepth = (chunk.CHUNK_SIZE - 1) / 2;
 	int maxHeight = (chunk.CHUNK_SIZE - 1) / 2;
 
-	int width = 10 + rand() % (maxWidth);
-	int depth = 10 + rand() % (maxDepth);
-	int height = 10 + rand() % (maxHeight);
+	int width = 10 + rng.range(maxWidth);
+	int depth = 10 + rng.range(maxDepth);
+	int height = 10 + rng.range(maxHeight);
 
-	int x = rand() % (chunk.CHUNK_SIZE - 1 - width);
-	int z = rand() % (chunk.CHUNK_SIZE - 1 - depth);
-	int y = rand() % (chunk.CHUNK_SIZE - 1 - height);
+	int x = rng.range(chunk.CHUNK_SIZE - 1 - width);
+	int z = rng.range(chunk.CHUNK_SIZE - 1 - depth);
+	int y = rng.range(chunk.CHUNK_SIZE - 1 - height);
 	BlockType type = STONE;
 
 	//chunk.absolute_positionX, chunk.absolute_positionZ are used for calculating portal position in room
@@ -31,7 +31,7 @@ void Generators::generate_stairs(Chunk &chunk, int startX, int startY, int start
 			int blockZ = startZ + y * direction;
 
 			int index = blockX * chunk.CHUNK_SIZE * chunk.CHUNK_SIZE + blockY * chunk.CHUNK_SIZE + blockZ;
-			chunk.blocks[index] = STONE; // Set the block to stone
+			chunk.blocks.set(index, STONE); // Set the block to stone
 		}
 	}
 }
@@ -46,14 +46,12 @@ void Generators::generate_bridge(Chunk &chunk, int startX, int startY, int start
 			int blockZ = startZ + z;
 
 			int index = blockX * chunk.CHUNK_SIZE * chunk.CHUNK_SIZE + blockY * chunk.CHUNK_SIZE + blockZ;
-			chunk.blocks[index] = STONE; // Set the block to stone
+			chunk.blocks.set(index, STONE); // Set the block to stone
 		}
 	}
 }
 
 void Generators::generate_pool(Chunk &chunk, int startX, int startY, int startZ, int width, int depth) {
-	int poolHeight = 1; // Height of the pool
-
 	for (int x = 0; x < width; ++x) {
 		for (int z = 0; z < depth; ++z) {
 			int blockX = startX + x;
@@ -61,7 +59,7 @@ void Generators::generate_pool(Chunk &chunk, int startX, int startY, int startZ,
 			int blockZ = startZ + z;
 
 			int index = blockX * chunk.CHUNK_SIZE * chunk.CHUNK_SIZE + blockY * chunk.CHUNK_SIZE + blockZ;
-			chunk.blocks[index] = STONE; // Set the block to water
+			chunk.blocks.set(index, STONE); // Set the block to water
 		}
 	}
 }
@@ -77,64 +75,117 @@ void Generators::generate_overhang(Chunk &chunk, int startX, int startY, int sta
 				int blockZ = startZ + z;
 
 				int index = blockX * chunk.CHUNK_SIZE * chunk.CHUNK_SIZE + blockY * chunk.CHUNK_SIZE + blockZ;
-				chunk.blocks[index] = STONE; // Set the block to stone
+				chunk.blocks.set(index, STONE); // Set the block to stone
 			}
 		}
 	}
 }
 
-void Generators::carve_room(Chunk &chunk) {
-	for (int x = 0; x < chunk.CHUNK_SIZE; ++x) {
-		for (int y = 0; y < chunk.CHUNK_SIZE; ++y) {
-			for (int z = 0; z < chunk.CHUNK_SIZE; ++z) {
-				// Calculate the 1D index in the chunk array
-				int index = x * chunk.CHUNK_SIZE * chunk.CHUNK_SIZE + y * chunk.CHUNK_SIZE + z;
-
-				// Check if the block is inside the room's boundaries
-				bool insideRoom = (x >= chunk.room.x && x < chunk.room.x + chunk.room.width &&
-					y >= chunk.room.y && y < chunk.room.y + chunk.room.height &&
-					z >= chunk.room.z && z < chunk.room.z + chunk.room.depth);
-
-				// Check if the block is on the immediate border of the room
-				bool onBorder = false;
-				if ((x == chunk.room.x - 1 || x == chunk.room.x + chunk.room.width) &&
-					y >= chunk.room.y && y < chunk.room.y + chunk.room.height &&
-					z >= chunk.room.z && z < chunk.room.z + chunk.room.depth) {
-					onBorder = true;
-				}
-				else if ((y == chunk.room.y - 1 || y == chunk.room.y + chunk.room.height) &&
-					x >= chunk.room.x && x < chunk.room.x + chunk.room.width &&
-					z >= chunk.room.z && z < chunk.room.z + chunk.room.depth) {
-					onBorder = true;
-				}
-				else if ((z == chunk.room.z - 1 || z == chunk.room.z + chunk.room.depth) &&
-					x >= chunk.room.x && x < chunk.room.x + chunk.room.width &&
-					y >= chunk.room.y && y < chunk.room.y + chunk.room.height) {
-					onBorder = true;
-				}
+//a chunk that is still a single block type (every chunk straight out of generate_poolroom) takes the fast
+//path: the whole chunk becomes air in one fill_box and only the room's border is written back, which leaves
+//exactly the blocks the full scan below would
+static bool carve_uniform_room(Chunk &chunk) {
+	BlockType type;
+	if (!chunk.blocks.is_uniform(type)) {
+		return false;
+	}
+	if (type == GRASS) {
+		return true;	//grass is never carved
+	}
 
-				if (chunk.blocks[index] == GRASS) {
-					continue;
-				}
+	const Room &room = chunk.room;
+	int size = chunk.CHUNK_SIZE;
+	chunk.blocks.fill_box(0, 0, 0, size, size, size, INACTIVE);
 
-				if (insideRoom) {
-					// Inside the room, set the block as inactive
-					chunk.blocks[index] = INACTIVE;
-				}
-				else if (onBorder) {
-					// Border blocks, set the block as stone
-					if ((z == 12 || z == 13 || z == 14) && y > chunk.room.height) {
-						chunk.blocks[index] = INACTIVE;
-					}
+	auto keep = [&](int x, int y, int z) {
+		if (x < 0 || x >= size || y < 0 || y >= size || z < 0 || z >= size) {
+			return;
+		}
+		if ((z == 12 || z == 13 || z == 14) && y > room.height) {
+			return;
+		}
+		chunk.blocks.set(x, y, z, type);
+	};
 
+	for (int y = room.y; y < room.y + room.height; ++y) {
+		for (int z = room.z; z < room.z + room.depth; ++z) {
+			keep(room.x - 1, y, z);
+			keep(room.x + room.width, y, z);
+		}
+	}
+	for (int x = room.x; x < room.x + room.width; ++x) {
+		for (int z = room.z; z < room.z + room.depth; ++z) {
+			keep(x, room.y - 1, z);
+			keep(x, room.y + room.height, z);
+		}
+		for (int y = room.y; y < room.y + room.height; ++y) {
+			keep(x, y, room.z - 1);
+			keep(x, y, room.z + room.depth);
+		}
+	}
+	return true;
+}
 
-				}
-				else {
-					// Outside the room and not bordering, set the block as inactive
-					chunk.blocks[index] = INACTIVE;
+void Generators::carve_room(Chunk &chunk, ChunkRng &rng) {
+	//reads each section decoded once, sets only touch the block just read so the decoded copy stays valid
+	const int S = BlockStorage::SECTION_SIZE;
+	if (!carve_uniform_room(chunk)) {
+		chunk.blocks.for_each_section([&](int sx, int sy, int sz, BlockType uniform_type, const BlockType *types) {
+			for (int lx = 0; lx < S; ++lx) {
+				for (int ly = 0; ly < S; ++ly) {
+					for (int lz = 0; lz < S; ++lz) {
+						// Calculate the 1D index in the chunk array
+						int x = sx * S + lx, y = sy * S + ly, z = sz * S + lz;
+						int index = x * chunk.CHUNK_SIZE * chunk.CHUNK_SIZE + y * chunk.CHUNK_SIZE + z;
+						BlockType type = types ? types[(lx * S + ly) * S + lz] : uniform_type;
+
+						// Check if the block is inside the room's boundaries
+						bool insideRoom = (x >= chunk.room.x && x < chunk.room.x + chunk.room.width &&
+							y >= chunk.room.y && y < chunk.room.y + chunk.room.height &&
+							z >= chunk.room.z && z < chunk.room.z + chunk.room.depth);
+
+						// Check if the block is on the immediate border of the room
+						bool onBorder = false;
+						if ((x == chunk.room.x - 1 || x == chunk.room.x + chunk.room.width) &&
+							y >= chunk.room.y && y < chunk.room.y + chunk.room.height &&
+							z >= chunk.room.z && z < chunk.room.z + chunk.room.depth) {
+							onBorder = true;
+						}
+						else if ((y == chunk.room.y - 1 || y == chunk.room.y + chunk.room.height) &&
+							x >= chunk.room.x && x < chunk.room.x + chunk.room.width &&
+							z >= chunk.room.z && z < chunk.room.z + chunk.room.depth) {
+							onBorder = true;
+						}
+						else if ((z == chunk.room.z - 1 || z == chunk.room.z + chunk.room.depth) &&
+							x >= chunk.room.x && x < chunk.room.x + chunk.room.width &&
+							y >= chunk.room.y && y < chunk.room.y + chunk.room.height) {
+							onBorder = true;
+						}
+
+						if (type == GRASS) {
+							continue;
+						}
+
+						if (insideRoom) {
+							// Inside the room, set the block as inactive
+							chunk.blocks.set(index, INACTIVE);
+						}
+						else if (onBorder) {
+							// Border blocks, set the block as stone
+							if ((z == 12 || z == 13 || z == 14) && y > chunk.room.height) {
+								chunk.blocks.set(index, INACTIVE);
+							}
+
+
+						}
+						else {
+							// Outside the room and not bordering, set the block as inactive
+							chunk.blocks.set(index, INACTIVE);
+						}
+					}
 				}
 			}
-		}
+		});
 	}
 
 	// Randomly generate structures within the room
@@ -153,7 +204,6 @@ void Generators::carve_room(Chunk &chunk) {
 
 	// Generate stairs at both ends of the bridge
 	int stairWidth = 2; // Width of the stairs
-	int stairHeight = 2; // Height of the stairs (to match the bridge height)
 
 						 // Stairs at the start of the bridge (left side)
 	generate_stairs(chunk, roomX, roomY, bridgeZ, 1); // Direction: 1 for forward
@@ -163,18 +213,21 @@ void Generators::carve_room(Chunk &chunk) {
 
 
 	// Example: Generate a pool
-	int poolX = roomX + rand() % (roomWidth - 5); // Random X position within the room
-	int poolZ = roomZ + rand() % (roomDepth - 5); // Random Z position within the room
-	int poolWidth = 3 + rand() % 5; // Random pool width
-	int poolDepth = 3 + rand() % 5; // Random pool depth
+	int poolX = roomX + rng.range(roomWidth - 5); // Random X position within the room
+	int poolZ = roomZ + rng.range(roomDepth - 5); // Random Z position within the room
+	int poolWidth = 3 + rng.range(5); // Random pool width
+	int poolDepth = 3 + rng.range(5); // Random pool depth
 	generate_pool(chunk, poolX, roomY, poolZ, poolWidth, poolDepth);
 
 	// Example: Generate an overhang
-	int overhangX = roomX + rand() % (roomWidth - 5); // Random X position within the room
-	int overhangZ = roomZ + rand() % (roomDepth - 5); // Random Z position within the room
-	int overhangWidth = 3 + rand() % 5; // Random overhang width
-	int overhangDepth = 3 + rand() % 5; // Random overhang depth
+	int overhangX = roomX + rng.range(roomWidth - 5); // Random X position within the room
+	int overhangZ = roomZ + rng.range(roomDepth - 5); // Random Z position within the room
+	int overhangWidth = 3 + rng.range(5); // Random overhang width
+	int overhangDepth = 3 + rng.range(5); // Random overhang depth
 	generate_overhang(chunk, overhangX, roomY + roomHeight - 2, overhangZ, overhangWidth, overhangDepth);
 
+	//sections the carving and structures left holding one type go back to being stored as just that type
+	chunk.blocks.compact();
+
 
 }
\ No newline at end of file
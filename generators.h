@@ -2,12 +2,17 @@
 
 #include "chunk.h"
 #include "block_type.h"
+#include "chunk_rng.h"
 
 
 namespace Generators {
 
-	void generate_poolroom(Chunk &chunk);
-	void carve_room(Chunk &chunk);
+	//bump whenever generated chunks change for the same seed: the generators, the ChunkRng streams or the Room
+	//layout. region files are kept per version, so chunks saved by an older generator are never loaded
+	const uint32_t GENERATOR_VERSION = 1;
+
+	void generate_poolroom(Chunk &chunk, ChunkRng &rng);
+	void carve_room(Chunk &chunk, ChunkRng &rng);
 	void generate_stairs(Chunk &chunk, int startX, int startY, int startZ, int direction);
 	void generate_bridge(Chunk &chunk, int startX, int startY, int startZ, int length);
 	void generate_pool(Chunk &chunk, int startX, int startY, int startZ, int width, int depth);
@@ -0,0 +1,54 @@
+#include "gpu_profiler.h"
+
+GpuProfiler::~GpuProfiler() {
+	for (Frame &frame : frames) {
+		for (Scope &scope : frame.scopes) {
+			glDeleteQueries(1, &scope.query);
+		}
+	}
+}
+
+void GpuProfiler::begin(const char *name) {
+	//a scope inside another one is left to the outer one
+	Frame &frame = frames[current];
+	if (depth++ > 0 || frame.used == MAX_SCOPES) {
+		return;
+	}
+	if (frame.used == frame.scopes.size()) {
+		Scope scope;
+		glGenQueries(1, &scope.query);
+		frame.scopes.push_back(scope);
+	}
+	Scope &scope = frame.scopes[frame.used++];
+	scope.name = name;
+	scope.start_us = Profiler::instance().now_us();
+	glBeginQuery(GL_TIME_ELAPSED, scope.query);
+	open = true;
+}
+
+void GpuProfiler::end() {
+	if (--depth > 0 || !open) {
+		return;
+	}
+	glEndQuery(GL_TIME_ELAPSED);
+	open = false;
+}
+
+void GpuProfiler::end_frame() {
+	current = (current + 1) % FRAMES_IN_FLIGHT;
+	Frame &frame = frames[current];
+	Profiler &profiler = Profiler::instance();
+	for (size_t i = 0; i < frame.used; ++i) {
+		const Scope &scope = frame.scopes[i];
+		GLint available = 0;
+		glGetQueryObjectiv(scope.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			++dropped;
+			continue;
+		}
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(scope.query, GL_QUERY_RESULT, &nanoseconds);
+		profiler.record_gpu(scope.name, scope.start_us, (int64_t)(nanoseconds / 1000));
+	}
+	frame.used = 0;
+}
@@ -0,0 +1,74 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <vector>
+#include "glad/glad.h"
+#include "profiler.h"
+
+//GL_TIME_ELAPSED queries around the render passes, reported to the Profiler as GPU stages. the queries
+//are double buffered: a frame's results are read at the end of the next frame, when the GPU is done with
+//them, instead of stalling on them, so GPU stages lag one frame behind. elapsed time queries can't
+//overlap, a scope nested in another one isn't timed on its own. main thread only
+class GpuProfiler {
+
+public:
+
+	static constexpr int FRAMES_IN_FLIGHT = 2;
+	static constexpr int MAX_SCOPES = 16;		//per frame, scopes past this aren't timed
+
+	GpuProfiler() = default;
+	~GpuProfiler();
+	GpuProfiler(const GpuProfiler &) = delete;
+	GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+	void begin(const char *name);
+	void end();
+	//reports the results of the frame before this one and switches to its queries, once a frame after
+	//the last scope
+	void end_frame();
+
+	size_t dropped = 0;		//results still not available a frame later, not reported
+
+private:
+
+	struct Scope {
+		const char *name;
+		int64_t start_us;	//CPU time the scope began, where the trace puts it
+		GLuint query;
+	};
+
+	struct Frame {
+		std::vector<Scope> scopes;
+		size_t used = 0;
+	};
+
+	Frame frames[FRAMES_IN_FLIGHT];
+	int current = 0;
+	int depth = 0;			//scopes begun and not ended
+	bool open = false;		//whether the outermost one has a query running
+};
+
+//times the GPU work issued in the enclosing scope
+class GpuProfileScope {
+
+public:
+
+	GpuProfileScope(GpuProfiler &profiler, const char *name) : profiler(profiler) { profiler.begin(name); }
+	~GpuProfileScope() { profiler.end(); }
+	GpuProfileScope(const GpuProfileScope &) = delete;
+	GpuProfileScope &operator=(const GpuProfileScope &) = delete;
+
+private:
+
+	GpuProfiler &profiler;
+};
+
+#if VOXELITE_PROFILE
+#define PROFILE_GPU_SCOPE(profiler, name) GpuProfileScope PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(profiler, name)
+#define PROFILE_GPU_END_FRAME(profiler) (profiler).end_frame()
+#else
+#define PROFILE_GPU_SCOPE(profiler, name) ((void)0)
+#define PROFILE_GPU_END_FRAME(profiler) ((void)0)
+#endif
+
+#endif // !GPU_PROFILER_H
@@ -0,0 +1,122 @@
+#include "mesh_cache.h"
+#include "chunk_rng.h"
+#include <cstring>
+
+MeshCache::MeshCache(size_t max_bytes) : byte_cap(max_bytes) {
+}
+
+//folds bytes into the hash 8 at a time, the tail zero padded
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = (const uint8_t *)data;
+	while (size > 0) {
+		uint64_t word = 0;
+		size_t n = size < sizeof(word) ? size : sizeof(word);
+		std::memcpy(&word, bytes, n);
+		hash = ChunkRng::mix(hash ^ word);
+		bytes += n;
+		size -= n;
+	}
+	return hash;
+}
+
+uint64_t MeshCache::mesh_key(const Chunk &chunk, MeshingMode mode, const ChunkBorders &borders) {
+	//the serialized palette form is a few KB even for a mixed chunk, far less than the blocks themselves
+	static thread_local std::vector<uint8_t> serialized;
+	serialized.clear();
+	chunk.blocks.serialize(serialized);
+
+	uint64_t hash = ChunkRng::mix(((uint64_t)MESH_VERSION << 32) | (uint32_t)mode);
+	hash = hash_bytes(hash, serialized.data(), serialized.size());
+	for (const std::vector<BlockType> &side : borders.sides) {
+		//a missing neighbour meshes differently from one of any size, so the length goes in too
+		hash = ChunkRng::mix(hash ^ side.size());
+		hash = hash_bytes(hash, side.data(), side.size() * sizeof(BlockType));
+	}
+	return hash ? hash : 1;
+}
+
+bool MeshCache::fetch(Chunk &chunk, uint64_t key) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	auto it = cached.find({ chunk.chunk_world_xposition, chunk.chunk_world_zposition });
+	if (it == cached.end() || it->second.key != key) {
+		++misses;
+		return false;
+	}
+
+	Entry &entry = it->second;
+	chunk.vertices.assign(entry.vertices.begin(), entry.vertices.end());
+	chunk.indices.assign(entry.indices.begin(), entry.indices.end());
+	chunk.block_number = entry.block_number;
+	chunk.mesh_key = key;
+	lru.splice(lru.begin(), lru, entry.lru_position);
+	++hits;
+	return true;
+}
+
+void MeshCache::store(Chunk &chunk) {
+	if (chunk.mesh_key == 0) {
+		chunk.release_mesh();
+		return;
+	}
+
+	std::pair<int, int> coords = { chunk.chunk_world_xposition, chunk.chunk_world_zposition };
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	auto it = cached.find(coords);
+	if (it == cached.end()) {
+		lru.push_front(coords);
+		it = cached.emplace(coords, Entry()).first;
+		it->second.lru_position = lru.begin();
+	}
+	else {
+		lru.splice(lru.begin(), lru, it->second.lru_position);
+		if (it->second.key == chunk.mesh_key) {
+			chunk.release_mesh();	//the mesh it was fetched from is still here
+			return;
+		}
+		used_bytes -= entry_bytes(it->second);
+	}
+
+	Entry &entry = it->second;
+	entry.key = chunk.mesh_key;
+	entry.block_number = chunk.block_number;
+	entry.vertices = std::move(chunk.vertices);
+	entry.indices = std::move(chunk.indices);
+	chunk.release_mesh();
+	used_bytes += entry_bytes(entry);
+	evict();
+}
+
+void MeshCache::set_max_bytes(size_t bytes) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	byte_cap = bytes;
+	evict();
+}
+
+size_t MeshCache::max_bytes() {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	return byte_cap;
+}
+
+size_t MeshCache::bytes() {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	return used_bytes;
+}
+
+size_t MeshCache::entries() {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	return cached.size();
+}
+
+size_t MeshCache::entry_bytes(const Entry &entry) {
+	return entry.vertices.capacity() * sizeof(ChunkVertex) + entry.indices.capacity() * sizeof(int);
+}
+
+void MeshCache::evict() {
+	while (used_bytes > byte_cap && !lru.empty()) {
+		auto it = cached.find(lru.back());
+		used_bytes -= entry_bytes(it->second);
+		cached.erase(it);
+		lru.pop_back();
+		++evictions;
+	}
+}
@@ -0,0 +1,72 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <vector>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include "chunk.h"
+#include "chunk_registry.h"
+
+//CPU meshes of uploaded chunks, handed over when the chunk becomes resident, so a chunk loaded again with
+//the same blocks, neighbour borders and meshing mode copies its old vertex and index buffers instead of
+//running the mesher. entries are keyed by chunk coordinates and checked against a hash of everything the
+//mesh was built from. the least recently used entries are evicted once they take more than max_bytes.
+//
+//off by default. the CPU mesh only exists until the upload, so the cache has to take it then and keep it for
+//as long as the chunk stays resident, a second copy of what is already on the GPU for every chunk in view,
+//up to max_bytes. that buys skipping the mesher when a chunk comes back unchanged, which pays off for a
+//camera moving back and forth over the same ground and not at all for one that keeps going
+class MeshCache {
+
+public:
+
+	//part of every key, bump it whenever the mesher output changes so older meshes stop matching
+	static const uint32_t MESH_VERSION = 1;
+	static constexpr size_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+	MeshCache(size_t max_bytes = DEFAULT_MAX_BYTES);
+
+	//hash of the chunk's blocks, its neighbour borders and the meshing mode, never 0
+	static uint64_t mesh_key(const Chunk &chunk, MeshingMode mode, const ChunkBorders &borders);
+
+	//copies the cached mesh into the chunk if there is one for its coordinates built from the same key.
+	//safe to call from the workers
+	bool fetch(Chunk &chunk, uint64_t key);
+	//takes the chunk's mesh vectors, keyed by chunk.mesh_key, evicting old entries to stay under the cap.
+	//the chunk is left without a CPU mesh either way
+	void store(Chunk &chunk);
+
+	void set_max_bytes(size_t bytes);
+	size_t max_bytes();
+	size_t bytes();
+	size_t entries();
+
+	std::atomic<bool> enabled{ false };
+	std::atomic<size_t> hits{ 0 };
+	std::atomic<size_t> misses{ 0 };
+	std::atomic<size_t> evictions{ 0 };
+
+private:
+
+	struct Entry {
+		uint64_t key;
+		int block_number;
+		std::vector<ChunkVertex> vertices;
+		std::vector<int> indices;
+		std::list<std::pair<int, int>>::iterator lru_position;
+	};
+
+	static size_t entry_bytes(const Entry &entry);
+	void evict();	//caller must hold cache_mutex
+
+	std::mutex cache_mutex;
+	std::unordered_map<std::pair<int, int>, Entry, PairHash> cached;
+	std::list<std::pair<int, int>> lru;		//most recently used first
+	size_t used_bytes = 0;
+	size_t byte_cap;
+};
+
+#endif // !MESH_CACHE_H
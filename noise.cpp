@@ -1,46 +1,40 @@
 
 #include "noise.h"
+#include "chunk_rng.h"
+#include <algorithm>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NOISE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define NOISE_TARGET_SSE2
+#define NOISE_TARGET_AVX2
+#else
+#define NOISE_TARGET_SSE2 __attribute__((target("sse2")))
+#define NOISE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
 
-// Function to compute the dot product of two std::vectors
-float dot(const std::vector<float>& v1, const std::vector<float>& v2) {
-	return v1[0] * v2[0] + v1[1] * v2[1];
-}
-
-// Shuffle function to shuffle a vector
-void Shuffle(std::vector<int>& arrayToShuffle) {
-	std::random_device rd;
-	std::mt19937 g(rd());
-	std::shuffle(arrayToShuffle.begin(), arrayToShuffle.end(), g);
-}
+// Permutation table, duplicated so corner lookups never need to wrap
+static int permutation[512];
 
-// Function to create a permutation table
-std::vector<int> MakePermutation() {
-	std::vector<int> permutation(256);
+//fisher-yates with the seed hashed per swap rather than std::shuffle, whose output differs between
+//standard libraries, so a seed gives the same terrain on every platform
+void Noise::set_seed(uint64_t seed) {
 	for (int i = 0; i < 256; i++) {
 		permutation[i] = i;
 	}
 
-	Shuffle(permutation);
-
-	// Duplicate the permutation array
-	permutation.insert(permutation.end(), permutation.begin(), permutation.end());
+	for (int i = 255; i > 0; --i) {
+		int j = (int)(ChunkRng::mix(seed + (uint64_t)i) % (uint64_t)(i + 1));
+		std::swap(permutation[i], permutation[j]);
+	}
 
-	return permutation;
+	std::copy(permutation, permutation + 256, permutation + 256);
 }
 
-// Function to get a constant vector based on value from permutation table
-std::vector<float> GetConstantVector(int v) {
-	int h = v & 3;
-	if (h == 0)
-		return { 1.0f, 1.0f };
-	else if (h == 1)
-		return { -1.0f, 1.0f };
-	else if (h == 2)
-		return { -1.0f, -1.0f };
-	else
-		return { 1.0f, -1.0f };
-}
+static bool permutation_ready = (Noise::set_seed(0), true);
 
 // Fade function for smoothing
 float Fade(float t) {
@@ -52,40 +46,322 @@ float Lerp(float t, float a1, float a2) {
 	return a1 + t * (a2 - a1);
 }
 
-// Global permutation table
-std::vector<int> Permutation = MakePermutation();
-
-// Function to compute 2D Perlin Noise using std::vector<float> for points
-float Noise2D(float x, float y) {
-	int X = (int)std::floor(x) & 255;
-	int Y = (int)std::floor(y) & 255;
+//dot product of the corner offset with the corner's gradient, one of (1,1) (-1,1) (-1,-1) (1,-1)
+static inline float gradient_dot(int hash, float x, float y) {
+	int h = hash & 3;
+	float gx = (h == 0 || h == 3) ? 1.0f : -1.0f;
+	float gy = (h < 2) ? 1.0f : -1.0f;
+	return gx * x + gy * y;
+}
 
-	float xf = x - std::floor(x);
-	float yf = y - std::floor(y);
+float Noise::perlin2(float x, float y) {
+	float x_floor = std::floor(x);
+	float y_floor = std::floor(y);
+	int X = (int)x_floor & 255;
+	int Y = (int)y_floor & 255;
 
-	std::vector<float> topRight = { xf - 1.0f, yf - 1.0f };
-	std::vector<float> topLeft = { xf, yf - 1.0f };
-	std::vector<float> bottomRight = { xf - 1.0f, yf };
-	std::vector<float> bottomLeft = { xf, yf };
+	float xf = x - x_floor;
+	float yf = y - y_floor;
 
 	// Select a value from the permutation array for each of the 4 corners
-	int valueTopRight = Permutation[Permutation[X + 1] + Y + 1];
-	int valueTopLeft = Permutation[Permutation[X] + Y + 1];
-	int valueBottomRight = Permutation[Permutation[X + 1] + Y];
-	int valueBottomLeft = Permutation[Permutation[X] + Y];
-
-	// Dot product for each corner
-	float dotTopRight = dot(topRight, GetConstantVector(valueTopRight));
-	float dotTopLeft = dot(topLeft, GetConstantVector(valueTopLeft));
-	float dotBottomRight = dot(bottomRight, GetConstantVector(valueBottomRight));
-	float dotBottomLeft = dot(bottomLeft, GetConstantVector(valueBottomLeft));
-
-	// Fade values
+	int valueTopRight = permutation[permutation[X + 1] + Y + 1];
+	int valueTopLeft = permutation[permutation[X] + Y + 1];
+	int valueBottomRight = permutation[permutation[X + 1] + Y];
+	int valueBottomLeft = permutation[permutation[X] + Y];
+
+	float dotTopRight = gradient_dot(valueTopRight, xf - 1.0f, yf - 1.0f);
+	float dotTopLeft = gradient_dot(valueTopLeft, xf, yf - 1.0f);
+	float dotBottomRight = gradient_dot(valueBottomRight, xf - 1.0f, yf);
+	float dotBottomLeft = gradient_dot(valueBottomLeft, xf, yf);
+
 	float u = Fade(xf);
 	float v = Fade(yf);
 
-	// Interpolate results
 	return Lerp(u,
 		Lerp(v, dotBottomLeft, dotTopLeft),
 		Lerp(v, dotBottomRight, dotTopRight));
-}
\ No newline at end of file
+}
+
+float Noise2D(float x, float y) {
+	return Noise::perlin2(x, y);
+}
+
+float Noise::fbm2(float x, float y, const FbmSettings &settings) {
+	float sum = 0.0f;
+	float frequency = settings.frequency;
+	float amplitude = 1.0f;
+	for (int octave = 0; octave < settings.octaves; ++octave) {
+		sum += amplitude * perlin2(x * frequency, y * frequency);
+		frequency *= settings.lacunarity;
+		amplitude *= settings.gain;
+	}
+	return sum;
+}
+
+//row kernels: noise at x0 + i * step for i in [first, count) along the row at y, scaled by amplitude and
+//either written to or added onto out[i]. each returns having done every sample so the wider kernels can
+//hand their leftover tail to the scalar one
+static void perlin2_row_scalar(float x0, float step, float y, int first, int count, float amplitude, bool accumulate, float *out) {
+	for (int i = first; i < count; ++i) {
+		float n = amplitude * Noise::perlin2(x0 + (float)i * step, y);
+		out[i] = accumulate ? out[i] + n : n;
+	}
+}
+
+#ifdef NOISE_X86
+
+NOISE_TARGET_SSE2
+static inline __m128 fade_sse2(__m128 t) {
+	__m128 r = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(6.0f), t), _mm_set1_ps(15.0f));
+	r = _mm_add_ps(_mm_mul_ps(r, t), _mm_set1_ps(10.0f));
+	return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(r, t), t), t);
+}
+
+//gradient dot as sign flips: h = 1 or 2 negates x, h = 2 or 3 negates y
+NOISE_TARGET_SSE2
+static inline __m128 gradient_dot_sse2(__m128i hash, __m128 x, __m128 y) {
+	__m128i h = _mm_and_si128(hash, _mm_set1_epi32(3));
+	__m128i flip_x = _mm_slli_epi32(_mm_and_si128(_mm_xor_si128(h, _mm_srli_epi32(h, 1)), _mm_set1_epi32(1)), 31);
+	__m128i flip_y = _mm_slli_epi32(_mm_srli_epi32(h, 1), 31);
+	return _mm_add_ps(_mm_xor_ps(x, _mm_castsi128_ps(flip_x)), _mm_xor_ps(y, _mm_castsi128_ps(flip_y)));
+}
+
+NOISE_TARGET_SSE2
+static inline __m128i lookup_sse2(__m128i index) {
+	alignas(16) int lanes[4];
+	_mm_store_si128((__m128i *)lanes, index);
+	return _mm_setr_epi32(permutation[lanes[0]], permutation[lanes[1]], permutation[lanes[2]], permutation[lanes[3]]);
+}
+
+NOISE_TARGET_SSE2
+static void perlin2_row_sse2(float x0, float step, float y, int count, float amplitude, bool accumulate, float *out) {
+	float y_floor = std::floor(y);
+	int Y = (int)y_floor & 255;
+	float yf = y - y_floor;
+	__m128 yf0 = _mm_set1_ps(yf);
+	__m128 yf1 = _mm_set1_ps(yf - 1.0f);
+	__m128 v = _mm_set1_ps(Fade(yf));
+	__m128i Yv = _mm_set1_epi32(Y);
+	__m128i one = _mm_set1_epi32(1);
+	__m128 onef = _mm_set1_ps(1.0f);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 index = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3)));
+		__m128 x = _mm_add_ps(_mm_set1_ps(x0), _mm_mul_ps(index, _mm_set1_ps(step)));
+
+		//floor without sse4.1: truncate, then step down where that rounded up
+		__m128i xi = _mm_cvttps_epi32(x);
+		__m128 x_floor = _mm_cvtepi32_ps(xi);
+		__m128 above = _mm_cmpgt_ps(x_floor, x);
+		x_floor = _mm_sub_ps(x_floor, _mm_and_ps(above, onef));
+		xi = _mm_add_epi32(xi, _mm_castps_si128(above));	//above is all ones (-1) where it rounded up
+
+		__m128i X = _mm_and_si128(xi, _mm_set1_epi32(255));
+		__m128 xf0 = _mm_sub_ps(x, x_floor);
+		__m128 xf1 = _mm_sub_ps(xf0, onef);
+
+		__m128i px0 = _mm_add_epi32(lookup_sse2(X), Yv);
+		__m128i px1 = _mm_add_epi32(lookup_sse2(_mm_add_epi32(X, one)), Yv);
+
+		__m128 dotTopRight = gradient_dot_sse2(lookup_sse2(_mm_add_epi32(px1, one)), xf1, yf1);
+		__m128 dotTopLeft = gradient_dot_sse2(lookup_sse2(_mm_add_epi32(px0, one)), xf0, yf1);
+		__m128 dotBottomRight = gradient_dot_sse2(lookup_sse2(px1), xf1, yf0);
+		__m128 dotBottomLeft = gradient_dot_sse2(lookup_sse2(px0), xf0, yf0);
+
+		__m128 u = fade_sse2(xf0);
+		__m128 left = _mm_add_ps(dotBottomLeft, _mm_mul_ps(v, _mm_sub_ps(dotTopLeft, dotBottomLeft)));
+		__m128 right = _mm_add_ps(dotBottomRight, _mm_mul_ps(v, _mm_sub_ps(dotTopRight, dotBottomRight)));
+		__m128 n = _mm_mul_ps(_mm_set1_ps(amplitude), _mm_add_ps(left, _mm_mul_ps(u, _mm_sub_ps(right, left))));
+
+		if (accumulate) {
+			n = _mm_add_ps(_mm_loadu_ps(out + i), n);
+		}
+		_mm_storeu_ps(out + i, n);
+	}
+	perlin2_row_scalar(x0, step, y, i, count, amplitude, accumulate, out);
+}
+
+NOISE_TARGET_AVX2
+static inline __m256 fade_avx2(__m256 t) {
+	__m256 r = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(6.0f), t), _mm256_set1_ps(15.0f));
+	r = _mm256_add_ps(_mm256_mul_ps(r, t), _mm256_set1_ps(10.0f));
+	return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(r, t), t), t);
+}
+
+NOISE_TARGET_AVX2
+static inline __m256 gradient_dot_avx2(__m256i hash, __m256 x, __m256 y) {
+	__m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(3));
+	__m256i flip_x = _mm256_slli_epi32(_mm256_and_si256(_mm256_xor_si256(h, _mm256_srli_epi32(h, 1)), _mm256_set1_epi32(1)), 31);
+	__m256i flip_y = _mm256_slli_epi32(_mm256_srli_epi32(h, 1), 31);
+	return _mm256_add_ps(_mm256_xor_ps(x, _mm256_castsi256_ps(flip_x)), _mm256_xor_ps(y, _mm256_castsi256_ps(flip_y)));
+}
+
+NOISE_TARGET_AVX2
+static void perlin2_row_avx2(float x0, float step, float y, int count, float amplitude, bool accumulate, float *out) {
+	float y_floor = std::floor(y);
+	int Y = (int)y_floor & 255;
+	float yf = y - y_floor;
+	__m256 yf0 = _mm256_set1_ps(yf);
+	__m256 yf1 = _mm256_set1_ps(yf - 1.0f);
+	__m256 v = _mm256_set1_ps(Fade(yf));
+	__m256i Yv = _mm256_set1_epi32(Y);
+	__m256i one = _mm256_set1_epi32(1);
+	__m256 onef = _mm256_set1_ps(1.0f);
+
+	//a row at chunk sampling rates only crosses a handful of lattice cells. when it crosses at most 8 the
+	//corner hashes of those cells are looked up once and picked per lane with a register permute instead
+	//of four gathers a block
+	int first_cell = (int)std::floor(x0);
+	int last_cell = count > 0 ? (int)std::floor(x0 + (float)(count - 1) * step) : first_cell;
+	bool few_cells = last_cell - first_cell < 8 && step >= 0.0f;
+	alignas(32) int bottom[9] = {}, top[9] = {};
+	if (few_cells) {
+		for (int c = 0; c < 9; ++c) {
+			int p = permutation[(first_cell + c) & 255] + Y;
+			bottom[c] = permutation[p];
+			top[c] = permutation[p + 1];
+		}
+	}
+	__m256i bottom_left_cells = _mm256_load_si256((const __m256i *)bottom);
+	__m256i bottom_right_cells = _mm256_loadu_si256((const __m256i *)(bottom + 1));
+	__m256i top_left_cells = _mm256_load_si256((const __m256i *)top);
+	__m256i top_right_cells = _mm256_loadu_si256((const __m256i *)(top + 1));
+	__m256i first_cell_v = _mm256_set1_epi32(first_cell);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 index = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+		__m256 x = _mm256_add_ps(_mm256_set1_ps(x0), _mm256_mul_ps(index, _mm256_set1_ps(step)));
+
+		__m256 x_floor = _mm256_floor_ps(x);
+		__m256i cell = _mm256_cvttps_epi32(x_floor);
+		__m256 xf0 = _mm256_sub_ps(x, x_floor);
+		__m256 xf1 = _mm256_sub_ps(xf0, onef);
+
+		__m256i hTopRight, hTopLeft, hBottomRight, hBottomLeft;
+		if (few_cells) {
+			__m256i rel = _mm256_sub_epi32(cell, first_cell_v);
+			hTopRight = _mm256_permutevar8x32_epi32(top_right_cells, rel);
+			hTopLeft = _mm256_permutevar8x32_epi32(top_left_cells, rel);
+			hBottomRight = _mm256_permutevar8x32_epi32(bottom_right_cells, rel);
+			hBottomLeft = _mm256_permutevar8x32_epi32(bottom_left_cells, rel);
+		}
+		else {
+			__m256i X = _mm256_and_si256(cell, _mm256_set1_epi32(255));
+			__m256i px0 = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, X, 4), Yv);
+			__m256i px1 = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(X, one), 4), Yv);
+			hTopRight = _mm256_i32gather_epi32(permutation, _mm256_add_epi32(px1, one), 4);
+			hTopLeft = _mm256_i32gather_epi32(permutation, _mm256_add_epi32(px0, one), 4);
+			hBottomRight = _mm256_i32gather_epi32(permutation, px1, 4);
+			hBottomLeft = _mm256_i32gather_epi32(permutation, px0, 4);
+		}
+
+		__m256 dotTopRight = gradient_dot_avx2(hTopRight, xf1, yf1);
+		__m256 dotTopLeft = gradient_dot_avx2(hTopLeft, xf0, yf1);
+		__m256 dotBottomRight = gradient_dot_avx2(hBottomRight, xf1, yf0);
+		__m256 dotBottomLeft = gradient_dot_avx2(hBottomLeft, xf0, yf0);
+
+		__m256 u = fade_avx2(xf0);
+		__m256 left = _mm256_add_ps(dotBottomLeft, _mm256_mul_ps(v, _mm256_sub_ps(dotTopLeft, dotBottomLeft)));
+		__m256 right = _mm256_add_ps(dotBottomRight, _mm256_mul_ps(v, _mm256_sub_ps(dotTopRight, dotBottomRight)));
+		__m256 n = _mm256_mul_ps(_mm256_set1_ps(amplitude), _mm256_add_ps(left, _mm256_mul_ps(u, _mm256_sub_ps(right, left))));
+
+		if (accumulate) {
+			n = _mm256_add_ps(_mm256_loadu_ps(out + i), n);
+		}
+		_mm256_storeu_ps(out + i, n);
+	}
+	perlin2_row_scalar(x0, step, y, i, count, amplitude, accumulate, out);
+}
+
+static Noise::SimdLevel detect_simd_level() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int max_leaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);	//osxsave, avx, os saves ymm
+	bool avx2 = false;
+	if (avx && max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	bool sse2 = __builtin_cpu_supports("sse2");
+	bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+	if (avx2) return Noise::SIMD_AVX2;
+	if (sse2) return Noise::SIMD_SSE2;
+	return Noise::SIMD_SCALAR;
+}
+
+#else
+
+static Noise::SimdLevel detect_simd_level() {
+	return Noise::SIMD_SCALAR;
+}
+
+#endif
+
+Noise::SimdLevel Noise::simd_level() {
+	static const SimdLevel level = detect_simd_level();
+	return level;
+}
+
+const char *Noise::simd_level_name(SimdLevel level) {
+	switch (level) {
+	case SIMD_AVX2: return "AVX2";
+	case SIMD_SSE2: return "SSE2";
+	default:        return "scalar";
+	}
+}
+
+static void perlin2_row(Noise::SimdLevel level, float x0, float step, float y, int count, float amplitude, bool accumulate, float *out) {
+	//never run a kernel the cpu can't execute, whatever the caller asked for
+	level = std::min(level, Noise::simd_level());
+#ifdef NOISE_X86
+	if (level == Noise::SIMD_AVX2) {
+		perlin2_row_avx2(x0, step, y, count, amplitude, accumulate, out);
+		return;
+	}
+	if (level == Noise::SIMD_SSE2) {
+		perlin2_row_sse2(x0, step, y, count, amplitude, accumulate, out);
+		return;
+	}
+#endif
+	perlin2_row_scalar(x0, step, y, 0, count, amplitude, accumulate, out);
+}
+
+void Noise::perlin2_grid(float x0, float y0, float step, int width, int height, float *out) {
+	perlin2_grid(x0, y0, step, width, height, out, simd_level());
+}
+
+void Noise::perlin2_grid(float x0, float y0, float step, int width, int height, float *out, SimdLevel level) {
+	for (int j = 0; j < height; ++j) {
+		perlin2_row(level, x0, step, y0 + (float)j * step, width, 1.0f, false, out + j * width);
+	}
+}
+
+void Noise::fbm2_grid(float x0, float y0, float step, int width, int height, const FbmSettings &settings, float *out) {
+	fbm2_grid(x0, y0, step, width, height, settings, out, simd_level());
+}
+
+//each octave is added straight onto out, so there is no scratch buffer
+void Noise::fbm2_grid(float x0, float y0, float step, int width, int height, const FbmSettings &settings, float *out, SimdLevel level) {
+	float frequency = settings.frequency;
+	float amplitude = 1.0f;
+	for (int octave = 0; octave < settings.octaves; ++octave) {
+		for (int j = 0; j < height; ++j) {
+			float y = (y0 + (float)j * step) * frequency;
+			perlin2_row(level, x0 * frequency, step * frequency, y, width, amplitude, octave > 0, out + j * width);
+		}
+		frequency *= settings.lacunarity;
+		amplitude *= settings.gain;
+	}
+	if (settings.octaves <= 0) {
+		std::fill(out, out + width * height, 0.0f);
+	}
+}
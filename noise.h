@@ -1,24 +1,44 @@
 #ifndef NOISE_H
 #define NOISE_H
 
-#include <iostream>
 #include <cmath>
-#include <algorithm> // for std::shuffle
-#include <random> // for random device and random engine
-#include <vector>
-#include <math.h>
-
-// Function to compute the dot product of two std::vectors
-float dot(const std::vector<float>& v1, const std::vector<float>& v2);
-
-// Shuffle function to shuffle a vector
-void Shuffle(std::vector<int>& arrayToShuffle);
-
-// Function to create a permutation table
-std::vector<int> MakePermutation();
-
-// Function to get a constant vector based on value from permutation table
-std::vector<float> GetConstantVector(int v);
+#include <cstdint>
+
+//octaves summed by the fbm functions, each one frequency * lacunarity^i with amplitude gain^i
+struct FbmSettings {
+	int octaves = 4;
+	float frequency = 1.0f;
+	float lacunarity = 2.0f;
+	float gain = 0.5f;
+};
+
+//2D Perlin noise. everything here is allocation free, the grid functions evaluate a whole lattice of
+//samples (one row of a chunk's columns at a time) with the widest SIMD the cpu supports, picked at runtime
+namespace Noise {
+
+	enum SimdLevel {
+		SIMD_SCALAR,
+		SIMD_SSE2,
+		SIMD_AVX2
+	};
+
+	//reshuffles the permutation table, the noise is the same on every run for the same seed. the table is
+	//shared, so set it before any worker samples noise. seed 0 is used until this is called
+	void set_seed(uint64_t seed);
+
+	//widest level the cpu supports, detected once
+	SimdLevel simd_level();
+	const char *simd_level_name(SimdLevel level);
+
+	float perlin2(float x, float y);
+	float fbm2(float x, float y, const FbmSettings &settings);
+
+	//out[j * width + i] = perlin2(x0 + i * step, y0 + j * step), same values as the scalar version
+	void perlin2_grid(float x0, float y0, float step, int width, int height, float *out);
+	void perlin2_grid(float x0, float y0, float step, int width, int height, float *out, SimdLevel level);
+	void fbm2_grid(float x0, float y0, float step, int width, int height, const FbmSettings &settings, float *out);
+	void fbm2_grid(float x0, float y0, float step, int width, int height, const FbmSettings &settings, float *out, SimdLevel level);
+};
 
 // Fade function for smoothing
 float Fade(float t);
@@ -26,10 +46,7 @@ float Fade(float t);
 // Linear interpolation function
 float Lerp(float t, float a1, float a2);
 
-// Function to compute 2D Perlin Noise using std::vector<float> for points
+// 2D Perlin Noise, same as Noise::perlin2
 float Noise2D(float x, float y);
 
-// Global permutation table (to be defined in the implementation file)
-extern std::vector<int> Permutation;
-
 #endif
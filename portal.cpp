@@ -1,6 +1,9 @@
 #include "portal.h"
+#include <algorithm>
+#include <cmath>
 
 
+//chunks and their portals are constructed on the workers, so this never touches GL
 Portal::Portal() {
 
 	position = { 0.0, 0.0, 0.0 };
@@ -8,39 +11,10 @@ Portal::Portal() {
 	exit_position = { 0.0, 0.0, 0.0 };
 	camera_position = { 14.0, 10.0, 10.0 };
 
-	
-	// Create the VAO, VBO, and EBO
-	glGenVertexArrays(1, &vao);
-	glGenBuffers(1, &vbo);
-	glGenBuffers(1, &ebo);
-
-	// Bind the VAO
-	glBindVertexArray(vao);
-
-	// Bind and upload the VBO
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Bind and upload the EBO
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	// Set up the vertex attributes
-	// Position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Texture coordinate attribute
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	// Unbind the VAO
-	glBindVertexArray(0);
-
 }
 
 
-void Portal::setup_camera(Shader &portal_shader, glm::vec3 cp, glm::vec3 camera_front) {
+void Portal::setup_camera(glm::vec3 cp, glm::vec3 camera_front) {
 
 	//cp = to the relative positon of the main camera to the main portal (entrance portal)
 
@@ -54,102 +28,82 @@ void Portal::setup_camera(Shader &portal_shader, glm::vec3 cp, glm::vec3 camera_
 	// Set up the projection matrix (perspective projection)
 	projection_matrix = glm::perspective(glm::radians(90.0f), (float)1920 / (float)1080, 0.1f, 10000.0f);
 
-	// Upload matrices to the shader (assuming you have a shader program)
-	//portal_shader.setMat4("model", model_matrix);
-	portal_shader.setMat4("view", view_matrix);
-	portal_shader.setMat4("projection", projection_matrix);
-
-}
-
-void Portal::setup_framebuffer() {
-	glGenFramebuffers(1, &fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1920, 1080, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	// Attach the texture to the FBO
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-
-	unsigned int rbo;
-	glGenRenderbuffers(1, &rbo);
-	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1920, 1080);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-	// Check for completeness
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-		std::cerr << "Framebuffer is not complete!" << std::endl;
+	//the near plane is moved onto the exit portal's plane (an oblique projection) so whatever sits between
+	//the portal camera and the exit is clipped and culled instead of covering the view through the portal.
+	//the quad faces along z, the plane's normal points away from the camera. skipped when the camera is
+	//too close to the plane for the depth range to stay usable
+	if (std::abs(cp.z) > 0.01f) {
+		glm::vec4 exit_plane(0.0f, 0.0f, cp.z > 0.0f ? -1.0f : 1.0f, 0.0f);
+		exit_plane.w = -exit_plane.z * exit_position.z;
+		glm::vec4 c = glm::transpose(glm::inverse(view_matrix)) * exit_plane;
+		glm::vec4 corner = glm::inverse(projection_matrix) * glm::vec4(glm::sign(c.x), glm::sign(c.y), 1.0f, 1.0f);
+		c = c * (2.0f / glm::dot(c, corner));
+		projection_matrix[0][2] = c.x - projection_matrix[0][3];
+		projection_matrix[1][2] = c.y - projection_matrix[1][3];
+		projection_matrix[2][2] = c.z - projection_matrix[2][3];
+		projection_matrix[3][2] = c.w - projection_matrix[3][3];
 	}
-	// Unbind the FBO
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// Create the VAO, VBO, and EBO
-	glGenVertexArrays(1, &vao);
-	glGenBuffers(1, &vbo);
-	glGenBuffers(1, &ebo);
-
-	// Bind the VAO
-	glBindVertexArray(vao);
-
-	// Bind and upload the VBO
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	// Bind and upload the EBO
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	// Set up the vertex attributes
-	// Position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Texture coordinate attribute
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	// Unbind the VAO
-	glBindVertexArray(0);
 }
 
-void Portal::drawQuad() {
-	// Bind the VAO
-	glBindVertexArray(vao);
-
-	// Bind the texture (if provided)
-	if (texture != 0) {
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture);
+bool Portal::screen_rect(const glm::mat4 &view_projection, glm::vec3 viewer_position, int screen_width, int screen_height, PortalScreenRect &rect) const {
+	//the quad is drawn from its front (+z in model space) only
+	glm::vec3 normal = glm::vec3(model_matrix * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+	if (glm::dot(normal, viewer_position - position) <= 0.0f) {
+		return false;
 	}
 
-	// Draw the quad
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	glm::vec4 corners[4];
+	for (int i = 0; i < 4; ++i) {
+		corners[i] = view_projection * model_matrix * glm::vec4(vertices[i * 5], vertices[i * 5 + 1], vertices[i * 5 + 2], 1.0f);
+	}
+	//clips the quad against the near plane (z >= -w) first, corners behind the camera would otherwise
+	//project to the wrong side of the screen
+	glm::vec4 clipped[8];
+	int count = 0;
+	for (int i = 0; i < 4; ++i) {
+		const glm::vec4 &a = corners[i];
+		const glm::vec4 &b = corners[(i + 1) % 4];
+		float da = a.z + a.w;
+		float db = b.z + b.w;
+		if (da >= 0.0f) {
+			clipped[count++] = a;
+		}
+		if ((da >= 0.0f) != (db >= 0.0f)) {
+			clipped[count++] = a + (b - a) * (da / (da - db));
+		}
+	}
+	if (count == 0) {
+		return false;
+	}
 
-	// Unbind the VAO
-	glBindVertexArray(0);
+	glm::vec2 low(1.0f), high(-1.0f);
+	for (int i = 0; i < count; ++i) {
+		glm::vec2 ndc(clipped[i].x / clipped[i].w, clipped[i].y / clipped[i].w);
+		low = glm::vec2(std::min(low.x, ndc.x), std::min(low.y, ndc.y));
+		high = glm::vec2(std::max(high.x, ndc.x), std::max(high.y, ndc.y));
+	}
+	int x0 = std::max(0, (int)std::floor((low.x * 0.5f + 0.5f) * screen_width));
+	int y0 = std::max(0, (int)std::floor((low.y * 0.5f + 0.5f) * screen_height));
+	int x1 = std::min(screen_width, (int)std::ceil((high.x * 0.5f + 0.5f) * screen_width));
+	int y1 = std::min(screen_height, (int)std::ceil((high.y * 0.5f + 0.5f) * screen_height));
+	if (x0 >= x1 || y0 >= y1) {
+		return false;
+	}
+	rect = { x0, y0, x1 - x0, y1 - y0 };
+	return true;
 }
 
-void Portal::renderSceneFromPortalPerspective() {
-	// Bind the FBO
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-	glViewport(0, 0, 1920, 1080);
-
-	// Clear the texture
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	// Set up the camera for the portal's perspective
-	//Portal::setup_camera();
-
-	// Render a quad as seen through the portal
-	//drawQuad(quadVAO, 0); // No texture for the scene quad
-
-						  // Unbind the FBO
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-}
\ No newline at end of file
+//the portal shader samples the texture at the fragment's screen position, so the pixels the quad covers
+//are the same in the portal's framebuffer. scales and offsets clip space so the rect fills it
+glm::mat4 Portal::rect_view_projection(const PortalScreenRect &rect, int screen_width, int screen_height) const {
+	float x0 = 2.0f * rect.x / screen_width - 1.0f;
+	float x1 = 2.0f * (rect.x + rect.width) / screen_width - 1.0f;
+	float y0 = 2.0f * rect.y / screen_height - 1.0f;
+	float y1 = 2.0f * (rect.y + rect.height) / screen_height - 1.0f;
+	glm::mat4 narrow(1.0f);
+	narrow[0][0] = 2.0f / (x1 - x0);
+	narrow[1][1] = 2.0f / (y1 - y0);
+	narrow[3][0] = -(x1 + x0) / (x1 - x0);
+	narrow[3][1] = -(y1 + y0) / (y1 - y0);
+	return narrow * projection_matrix * view_matrix;
+}
@@ -1,17 +1,18 @@
 #pragma once
-#include "glad/glad.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <iostream>
-#include "shader.h"
 
+//pixels of the screen the portal quad covers, x and y from the bottom left like glScissor
+struct PortalScreenRect {
+	int x, y, width, height;
+};
+
+//where a chunk's portal is and the camera looking out of its exit. no GL objects, the framebuffer and quad
+//it is rendered with are a PortalTarget owned by the Renderer
 class Portal {
 public:
 
-	GLuint fbo;
-	GLuint texture;
-	GLuint vao, vbo, ebo;
 	glm::vec3 position;
 	glm::vec3 exit_position;
 	glm::mat4 view_matrix;
@@ -35,11 +36,14 @@ public:
 
 
 	Portal();
-	void draw_portal();
-	void setup_camera(Shader &portal_shader, glm::vec3 camera_position, glm::vec3 camera_front);
-	void setup_framebuffer();
-	void renderSceneFromPortalPerspective();
-	void drawQuad();
+	//places the portal camera at the exit, as far from it as the main camera is from the entrance, and sets
+	//view_matrix and projection_matrix for the portal pass
+	void setup_camera(glm::vec3 camera_position, glm::vec3 camera_front);
+	//the part of a screen_width x screen_height screen the quad covers when seen with view_projection from
+	//viewer_position. false when it is off screen or the viewer is behind it, the portal pass can be skipped
+	bool screen_rect(const glm::mat4 &view_projection, glm::vec3 viewer_position, int screen_width, int screen_height, PortalScreenRect &rect) const;
+	//the portal camera's projection * view narrowed to rect, for culling what the portal pass draws there
+	glm::mat4 rect_view_projection(const PortalScreenRect &rect, int screen_width, int screen_height) const;
 	~Portal() = default;
 
 };
\ No newline at end of file
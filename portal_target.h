@@ -0,0 +1,22 @@
+#ifndef PORTAL_TARGET_H
+#define PORTAL_TARGET_H
+
+#include "glad/glad.h"
+#include "portal.h"
+
+//the GL side of a chunk's portal: the framebuffer the portal pass renders into and the textured quad it is
+//shown on. owned by the Renderer, keyed by chunk id, main thread only
+struct PortalTarget {
+	GLuint fbo = 0;
+	GLuint texture = 0;
+	GLuint rbo = 0;
+	GLuint vao = 0, vbo = 0, ebo = 0;
+
+	//creates the framebuffer and uploads the portal's quad, needs a current GL context
+	void create(const Portal &portal);
+	void destroy();
+	bool created() const { return fbo != 0; }
+	void draw_quad() const;
+};
+
+#endif // !PORTAL_TARGET_H
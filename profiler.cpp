@@ -0,0 +1,150 @@
+#include "profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+
+Profiler &Profiler::instance() {
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()), frame_ms(HISTORY_FRAMES, 0.0f) {
+}
+
+int64_t Profiler::now_us() const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+//threads are numbered the first time they record, a thread_local keeps the number after that
+uint32_t Profiler::thread_index() {
+	static thread_local uint32_t index = UINT32_MAX;
+	if (index == UINT32_MAX) {
+		index = thread_count++;
+		std::lock_guard<std::mutex> lock(mutex);
+		if (thread_names.size() <= index) {
+			thread_names.resize(index + 1);
+		}
+		if (thread_names[index].empty()) {
+			thread_names[index] = "thread " + std::to_string(index);
+		}
+	}
+	return index;
+}
+
+void Profiler::record(const char *name, int64_t start_us, int64_t duration_us) {
+	uint32_t thread = thread_index();
+	std::lock_guard<std::mutex> lock(mutex);
+	add(name, false, thread, start_us, duration_us);
+}
+
+void Profiler::record_gpu(const char *name, int64_t start_us, int64_t duration_us) {
+	std::lock_guard<std::mutex> lock(mutex);
+	add(name, true, GPU_THREAD, start_us, duration_us);
+}
+
+void Profiler::name_thread(const char *name) {
+	uint32_t thread = thread_index();
+	std::lock_guard<std::mutex> lock(mutex);
+	thread_names[thread] = name;
+}
+
+//caller holds mutex
+void Profiler::add(const char *name, bool gpu, uint32_t thread, int64_t start_us, int64_t duration_us) {
+	ProfileEvent event = { name, thread, start_us, duration_us };
+	if (events.size() < MAX_EVENTS) {
+		events.push_back(event);
+	}
+	else {
+		events[next_event] = event;
+		next_event = (next_event + 1) % MAX_EVENTS;
+	}
+
+	for (ProfileStage &stage : stage_list) {
+		if (stage.gpu == gpu && (stage.name == name || !std::strcmp(stage.name, name))) {
+			stage.current += duration_us / 1000.0f;
+			return;
+		}
+	}
+	ProfileStage stage;
+	stage.name = name;
+	stage.gpu = gpu;
+	stage.history.assign(HISTORY_FRAMES, 0.0f);
+	stage.current = duration_us / 1000.0f;
+	stage_list.push_back(std::move(stage));
+}
+
+void Profiler::end_frame() {
+	int64_t now = now_us();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (frame_start_us > 0) {
+		frame_ms[history_position] = (now - frame_start_us) / 1000.0f;
+	}
+	frame_start_us = now;
+	for (ProfileStage &stage : stage_list) {
+		stage.history[history_position] = stage.current;
+		stage.current = 0.0f;
+	}
+	history_position = (history_position + 1) % HISTORY_FRAMES;
+}
+
+std::vector<ProfileStage> Profiler::stages() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return stage_list;
+}
+
+std::vector<float> Profiler::frame_history() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return frame_ms;
+}
+
+int Profiler::history_offset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return history_position;
+}
+
+//names are string literals of ours, only quotes and backslashes need escaping
+static void write_json_string(FILE *file, const char *text) {
+	std::fputc('"', file);
+	for (const char *c = text; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			std::fputc('\\', file);
+		}
+		std::fputc(*c, file);
+	}
+	std::fputc('"', file);
+}
+
+bool Profiler::write_chrome_trace(const std::string &path) {
+	std::vector<ProfileEvent> ordered;
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ordered.reserve(events.size());
+		ordered.insert(ordered.end(), events.begin() + next_event, events.end());
+		ordered.insert(ordered.end(), events.begin(), events.begin() + next_event);
+		names = thread_names;
+	}
+
+	FILE *file = std::fopen(path.c_str(), "wb");
+	if (!file) {
+		return false;
+	}
+	//complete ("X") events, plus one metadata ("M") event naming each thread
+	std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+	for (size_t t = 0; t < names.size(); ++t) {
+		std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":", first ? "" : ",\n", t);
+		write_json_string(file, names[t].c_str());
+		std::fprintf(file, "}}");
+		first = false;
+	}
+	std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", first ? "" : ",\n", GPU_THREAD);
+	for (const ProfileEvent &event : ordered) {
+		std::fprintf(file, ",\n{\"name\":");
+		write_json_string(file, event.name);
+		std::fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%" PRId64 ",\"dur\":%" PRId64 "}",
+			event.thread == GPU_THREAD ? "gpu" : "cpu", event.thread, event.start_us, event.duration_us);
+	}
+	std::fprintf(file, "\n]}\n");
+	return std::fclose(file) == 0;
+}
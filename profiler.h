@@ -0,0 +1,119 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+//VOXELITE_PROFILE 0 compiles every PROFILE_* macro to nothing. it is on unless NDEBUG is defined, define
+//it to 1 to profile a release build or to 0 to drop the timers from a debug one
+#ifndef VOXELITE_PROFILE
+#ifdef NDEBUG
+#define VOXELITE_PROFILE 0
+#else
+#define VOXELITE_PROFILE 1
+#endif
+#endif
+
+//one timed stretch of work on one thread, or on the GPU when thread is Profiler::GPU_THREAD
+struct ProfileEvent {
+	const char *name;		//a string literal
+	uint32_t thread;		//index given to the thread by the profiler, in the order threads first record
+	int64_t start_us;		//since the profiler was created
+	int64_t duration_us;
+};
+
+//the milliseconds a stage took in each of the last Profiler::HISTORY_FRAMES frames, summed over every
+//thread that ran it
+struct ProfileStage {
+	const char *name;
+	bool gpu;
+	std::vector<float> history;		//ring, the oldest frame at Profiler::history_offset()
+	float current = 0.0f;			//this frame so far
+};
+
+//collects scoped CPU timings from the main thread and the chunk workers and GPU timings from the
+//GpuProfiler. keeps every stage's per frame total for the editor's graphs and the last MAX_EVENTS events
+//for a Chrome trace (chrome://tracing or ui.perfetto.dev). recording takes a mutex, which is cheap for
+//the few scopes a frame or a chunk task records. use it through the PROFILE_* macros so it compiles out
+class Profiler {
+
+public:
+
+	static constexpr int HISTORY_FRAMES = 240;
+	static constexpr size_t MAX_EVENTS = 1 << 18;
+	static constexpr uint32_t GPU_THREAD = 0xffff;
+
+	static Profiler &instance();
+
+	int64_t now_us() const;
+	//an event on the calling thread
+	void record(const char *name, int64_t start_us, int64_t duration_us);
+	//an event on the GPU, start_us is when the CPU issued it
+	void record_gpu(const char *name, int64_t start_us, int64_t duration_us);
+	//the calling thread's name in traces
+	void name_thread(const char *name);
+	//moves every stage's total into its history and starts the next frame, main thread once a frame
+	void end_frame();
+
+	//copies of the stages and the frame times, for drawing without holding the lock
+	std::vector<ProfileStage> stages();
+	std::vector<float> frame_history();
+	int history_offset();
+	//writes the events kept so far as Chrome trace JSON, false when the file can't be written
+	bool write_chrome_trace(const std::string &path);
+
+private:
+
+	Profiler();
+	uint32_t thread_index();
+	void add(const char *name, bool gpu, uint32_t thread, int64_t start_us, int64_t duration_us);
+
+	std::chrono::steady_clock::time_point epoch;
+	std::mutex mutex;
+	std::vector<ProfileEvent> events;		//ring of MAX_EVENTS, next_event is the oldest once full
+	size_t next_event = 0;
+	std::vector<ProfileStage> stage_list;
+	std::vector<float> frame_ms;
+	int history_position = 0;
+	int64_t frame_start_us = 0;
+	std::vector<std::string> thread_names;	//by thread index
+	std::atomic<uint32_t> thread_count{ 0 };
+};
+
+//times the enclosing scope on the calling thread
+class ProfileScope {
+
+public:
+
+	explicit ProfileScope(const char *name) : name(name), start_us(Profiler::instance().now_us()) {}
+	~ProfileScope() {
+		Profiler &profiler = Profiler::instance();
+		profiler.record(name, start_us, profiler.now_us() - start_us);
+	}
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+
+	const char *name;
+	int64_t start_us;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if VOXELITE_PROFILE
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::instance().name_thread(name)
+#define PROFILE_END_FRAME() Profiler::instance().end_frame()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#endif
+
+#endif // !PROFILER_H
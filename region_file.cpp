@@ -0,0 +1,323 @@
+#include "region_file.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const size_t REGION_CHUNKS = RegionStore::REGION_SIZE * RegionStore::REGION_SIZE;
+static const size_t HEADER_SIZE = 8 + REGION_CHUNKS * 8;
+static const size_t RECORD_HEADER_SIZE = 20;
+static const int ROOM_FIELDS = 9;
+
+bool MappedFile::open(const std::string &path) {
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(handle);
+		return false;
+	}
+	HANDLE map = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!map) {
+		CloseHandle(handle);
+		return false;
+	}
+	void *view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(map);
+		CloseHandle(handle);
+		return false;
+	}
+	file = handle;
+	mapping = map;
+	bytes = (const uint8_t *)view;
+	length = (size_t)file_size.QuadPart;
+	return true;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void *view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);	//the mapping keeps the file referenced
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	bytes = (const uint8_t *)view;
+	length = (size_t)info.st_size;
+	return true;
+#endif
+}
+
+MappedFile::~MappedFile() {
+	if (!bytes) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(bytes);
+	CloseHandle(mapping);
+	CloseHandle(file);
+#else
+	munmap((void *)bytes, length);
+#endif
+}
+
+static uint32_t read_u32(const uint8_t *at) {
+	uint32_t value;
+	std::memcpy(&value, at, sizeof(value));
+	return value;
+}
+
+static void append_u32(std::vector<uint8_t> &out, uint32_t value) {
+	size_t at = out.size();
+	out.resize(at + sizeof(value));
+	std::memcpy(&out[at], &value, sizeof(value));
+}
+
+//fnv-1a, catches a record torn by a crash or read while its header entry was being rewritten
+static uint32_t checksum(const uint8_t *data, size_t size) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+//region coordinate and the chunk's slot within the region, rounding towards negative infinity
+static void region_of(int chunk_x, int chunk_z, int &region_x, int &region_z, int &slot) {
+	const int R = RegionStore::REGION_SIZE;
+	region_x = chunk_x >= 0 ? chunk_x / R : (chunk_x - (R - 1)) / R;
+	region_z = chunk_z >= 0 ? chunk_z / R : (chunk_z - (R - 1)) / R;
+	slot = (chunk_x - region_x * R) * R + (chunk_z - region_z * R);
+}
+
+RegionStore::~RegionStore() {
+	if (writer.joinable()) {
+		save_queue.close();	//the writer drains what is queued before it exits
+		writer.join();
+	}
+}
+
+bool RegionStore::open(const std::string &dir) {
+	std::error_code error;
+	std::filesystem::create_directories(dir, error);
+	if (error || writer.joinable()) {
+		return false;
+	}
+	directory = dir;
+	writer = std::thread(&RegionStore::writer_loop, this);
+	return true;
+}
+
+std::string RegionStore::region_path(int region_x, int region_z) const {
+	return directory + "/r." + std::to_string(region_x) + "." + std::to_string(region_z) + ".vxr";
+}
+
+std::shared_ptr<MappedFile> RegionStore::map_region(int region_x, int region_z) {
+	std::lock_guard<std::mutex> lock(map_mutex);
+	std::pair<int, int> region(region_x, region_z);
+	auto it = mapped.find(region);
+	if (it != mapped.end()) {
+		lru.splice(lru.begin(), lru, it->second.lru_position);
+		return it->second.file;
+	}
+
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->open(region_path(region_x, region_z))) {
+		file = nullptr;
+	}
+	while (mapped.size() >= MAX_MAPPED_REGIONS && !lru.empty()) {
+		unmap_region(lru.back());
+		++unmaps;
+	}
+	lru.push_front(region);
+	mapped[region] = { file, lru.begin() };
+	return file;
+}
+
+void RegionStore::unmap_region(std::pair<int, int> region) {
+	auto it = mapped.find(region);
+	if (it != mapped.end()) {
+		lru.erase(it->second.lru_position);
+		mapped.erase(it);
+	}
+}
+
+size_t RegionStore::mapped_regions() {
+	std::lock_guard<std::mutex> lock(map_mutex);
+	return mapped.size();
+}
+
+bool RegionStore::load(int chunk_x, int chunk_z, Chunk &chunk) {
+	if (!is_open()) {
+		return false;
+	}
+
+	int region_x, region_z, slot;
+	region_of(chunk_x, chunk_z, region_x, region_z, slot);
+	std::shared_ptr<MappedFile> file = map_region(region_x, region_z);
+
+	const uint8_t *data = file ? file->data() : nullptr;
+	size_t size = file ? file->size() : 0;
+	bool found = false;
+	if (size >= HEADER_SIZE && read_u32(data) == REGION_MAGIC && read_u32(data + 4) == REGION_VERSION) {
+		uint32_t offset = read_u32(data + 8 + slot * 8);
+		uint32_t length = read_u32(data + 12 + slot * 8);
+		if (offset >= HEADER_SIZE && length >= RECORD_HEADER_SIZE && (size_t)offset + length <= size) {
+			const uint8_t *record = data + offset;
+			uint32_t payload_size = read_u32(record + 12);
+			found = read_u32(record) == RECORD_MAGIC &&
+				(int)read_u32(record + 4) == chunk_x && (int)read_u32(record + 8) == chunk_z &&
+				payload_size == length - RECORD_HEADER_SIZE &&
+				read_u32(record + 16) == checksum(record + RECORD_HEADER_SIZE, payload_size) &&
+				decode_chunk(record + RECORD_HEADER_SIZE, payload_size, chunk);
+		}
+	}
+
+	if (found) {
+		++loads;
+	}
+	else {
+		++misses;
+	}
+	return found;
+}
+
+void RegionStore::save(const Chunk &chunk) {
+	if (!is_open()) {
+		return;
+	}
+
+	SaveRequest request;
+	request.chunk_x = chunk.chunk_world_xposition;
+	request.chunk_z = chunk.chunk_world_zposition;
+	encode_chunk(chunk, request.payload);
+
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		++pending;
+	}
+	if (!save_queue.push(std::move(request))) {
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		--pending;
+		pending_cv.notify_all();
+	}
+}
+
+void RegionStore::flush() {
+	std::unique_lock<std::mutex> lock(pending_mutex);
+	pending_cv.wait(lock, [this] { return pending == 0; });
+}
+
+void RegionStore::writer_loop() {
+	SaveRequest request;
+	while (save_queue.pop(request)) {
+		if (write_record(request)) {
+			++saves;
+		}
+		else {
+			++write_failures;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(pending_mutex);
+			--pending;
+		}
+		pending_cv.notify_all();
+	}
+}
+
+bool RegionStore::write_record(const SaveRequest &request) {
+	int region_x, region_z, slot;
+	region_of(request.chunk_x, request.chunk_z, region_x, region_z, slot);
+	std::string path = region_path(region_x, region_z);
+
+	FILE *file = std::fopen(path.c_str(), "r+b");
+	if (!file) {
+		//new region, start it with an empty header
+		file = std::fopen(path.c_str(), "w+b");
+		if (!file) {
+			return false;
+		}
+		std::vector<uint8_t> header;
+		append_u32(header, REGION_MAGIC);
+		append_u32(header, REGION_VERSION);
+		header.resize(HEADER_SIZE, 0);
+		std::fwrite(header.data(), 1, header.size(), file);
+	}
+
+	std::vector<uint8_t> record;
+	record.reserve(RECORD_HEADER_SIZE + request.payload.size());
+	append_u32(record, RECORD_MAGIC);
+	append_u32(record, (uint32_t)request.chunk_x);
+	append_u32(record, (uint32_t)request.chunk_z);
+	append_u32(record, (uint32_t)request.payload.size());
+	append_u32(record, checksum(request.payload.data(), request.payload.size()));
+	record.insert(record.end(), request.payload.begin(), request.payload.end());
+
+	//append the record first and only then point the header at it
+	bool ok = std::fseek(file, 0, SEEK_END) == 0;
+	long offset = ok ? std::ftell(file) : -1;
+	ok = ok && offset >= (long)HEADER_SIZE && std::fwrite(record.data(), 1, record.size(), file) == record.size();
+	ok = ok && std::fflush(file) == 0;
+
+	std::vector<uint8_t> entry;
+	append_u32(entry, (uint32_t)offset);
+	append_u32(entry, (uint32_t)record.size());
+	ok = ok && std::fseek(file, (long)(8 + slot * 8), SEEK_SET) == 0;
+	ok = ok && std::fwrite(entry.data(), 1, entry.size(), file) == entry.size();
+	ok = std::fclose(file) == 0 && ok;
+
+	//the next load maps the file again to see the new record
+	std::lock_guard<std::mutex> lock(map_mutex);
+	unmap_region({ region_x, region_z });
+	return ok;
+}
+
+void RegionStore::encode_chunk(const Chunk &chunk, std::vector<uint8_t> &payload) {
+	const Room &room = chunk.room;
+	const int fields[ROOM_FIELDS] = { room.x, room.y, room.z, room.width, room.height, room.depth,
+		room.chunk_position_x, room.chunk_position_z, (int)room.type };
+	for (int field : fields) {
+		append_u32(payload, (uint32_t)field);
+	}
+	chunk.blocks.serialize(payload);
+}
+
+bool RegionStore::decode_chunk(const uint8_t *payload, size_t size, Chunk &chunk) {
+	if (size < ROOM_FIELDS * 4) {
+		return false;
+	}
+	int fields[ROOM_FIELDS];
+	for (int i = 0; i < ROOM_FIELDS; ++i) {
+		fields[i] = (int)read_u32(payload + i * 4);
+	}
+
+	const uint8_t *data = payload + ROOM_FIELDS * 4;
+	const uint8_t *end = payload + size;
+	if (!chunk.blocks.deserialize(data, end) || data != end || chunk.blocks.side() != Chunk::CHUNK_SIZE) {
+		chunk.blocks.reset(Chunk::CHUNK_SIZE, STONE);	//back to what generation expects
+		return false;
+	}
+
+	chunk.room = { fields[0], fields[1], fields[2], fields[3], fields[4], fields[5], fields[6], fields[7], (BlockType)fields[8] };
+	return true;
+}
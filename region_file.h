@@ -0,0 +1,126 @@
+#ifndef REGION_FILE_H
+#define REGION_FILE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
+#include <cstdint>
+#include "chunk.h"
+#include "chunk_registry.h"
+#include "bounded_queue.h"
+
+//read only memory mapping of a whole file
+class MappedFile {
+
+public:
+
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const std::string &path);
+	const uint8_t *data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+
+	const uint8_t *bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void *file = nullptr;
+	void *mapping = nullptr;
+#endif
+};
+
+//generated chunks saved to disk so walking back into an area loads them instead of generating them again.
+//chunks are grouped into REGION_SIZE x REGION_SIZE regions, one file each named r.<x>.<z>.vxr:
+//
+//  header: u32 REGION_MAGIC, u32 REGION_VERSION, then per chunk (local x * REGION_SIZE + local z)
+//          u32 offset and u32 size of its latest record, offset 0 when the chunk was never saved
+//  record: u32 RECORD_MAGIC, i32 chunk x, i32 chunk z, u32 payload size, u32 payload checksum, then the
+//          payload: the chunk's Room as 9 i32 and its palette compressed BlockStorage
+//
+//records are only ever appended, saving a chunk again appends a new record and repoints its header entry.
+//values are in host byte order. reads map the region file, writes happen on a background writer thread
+class RegionStore {
+
+public:
+
+	static const int REGION_SIZE = 16;
+	static const uint32_t REGION_MAGIC = 0x47525856;	//"VXRG"
+	static const uint32_t RECORD_MAGIC = 0x4B435856;	//"VXCK"
+	static const uint32_t REGION_VERSION = 1;		//layout of the file only, what is in it is Generators::GENERATOR_VERSION
+	//regions kept mapped at once, the least recently loaded from is unmapped past this. a render distance of
+	//up to 16 chunks touches at most 9 regions
+	static const size_t MAX_MAPPED_REGIONS = 16;
+
+	RegionStore() = default;
+	~RegionStore();
+
+	//creates the directory if needed and starts the writer. a store that isn't open misses every load
+	//and ignores saves
+	bool open(const std::string &directory);
+	bool is_open() const { return writer.joinable(); }
+
+	//fills the chunk's room and blocks from its saved record, false if there is none or it is unreadable.
+	//safe to call from any thread
+	bool load(int chunk_x, int chunk_z, Chunk &chunk);
+	//serializes the chunk now and writes it on the writer thread. safe to call from any thread
+	void save(const Chunk &chunk);
+	//blocks until every save so far is on disk
+	void flush();
+
+	size_t mapped_regions();
+
+	std::atomic<size_t> loads{ 0 };				//chunks read back from disk
+	std::atomic<size_t> misses{ 0 };			//loads that found nothing and fell back to generating
+	std::atomic<size_t> saves{ 0 };				//records written
+	std::atomic<size_t> write_failures{ 0 };
+	std::atomic<size_t> unmaps{ 0 };			//regions dropped to stay under MAX_MAPPED_REGIONS
+
+	static void encode_chunk(const Chunk &chunk, std::vector<uint8_t> &payload);
+	static bool decode_chunk(const uint8_t *payload, size_t size, Chunk &chunk);
+
+private:
+
+	struct SaveRequest {
+		int chunk_x;
+		int chunk_z;
+		std::vector<uint8_t> payload;
+	};
+
+	void writer_loop();
+	bool write_record(const SaveRequest &request);
+	std::shared_ptr<MappedFile> map_region(int region_x, int region_z);
+	void unmap_region(std::pair<int, int> region);	//caller must hold map_mutex
+	std::string region_path(int region_x, int region_z) const;
+
+	std::string directory;
+
+	struct MappedRegion {
+		std::shared_ptr<MappedFile> file;
+		std::list<std::pair<int, int>>::iterator lru_position;
+	};
+
+	//mapped region files, nullptr for a region with no file yet. the writer drops a region's entry after
+	//appending to it so the next load maps the new size, loads in flight keep the old mapping alive. at most
+	//MAX_MAPPED_REGIONS stay mapped, the least recently used is dropped the same way
+	std::mutex map_mutex;
+	std::unordered_map<std::pair<int, int>, MappedRegion, PairHash> mapped;
+	std::list<std::pair<int, int>> lru;		//most recently used first
+
+	BoundedQueue<SaveRequest> save_queue{ 256 };
+	std::thread writer;
+	std::mutex pending_mutex;
+	std::condition_variable pending_cv;
+	size_t pending = 0;		//saves queued or being written
+};
+
+#endif // !REGION_FILE_H
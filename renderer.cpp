@@ -1,5 +1,8 @@
 
 #include "renderer.h"
+#include <cstddef>
+#include <chrono>
+#include <algorithm>
 
 void Renderer::renderWireframes() {
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -8,127 +11,135 @@ void Renderer::enableDepthTesting() {
 	glEnable(GL_DEPTH_TEST);
 }
 
-void Renderer::init_chunk_portal_buffers(Chunk &chunk) {
-
-	// Create the VAO, VBO, and EBO
-	glGenVertexArrays(1, &chunk.portal.vao);
-	glGenBuffers(1, &chunk.portal.vbo);
-	glGenBuffers(1, &chunk.portal.ebo);
-
-	// Bind the VAO
-	glBindVertexArray(chunk.portal.vao);
-
-	// Bind and upload the VBO
-	glBindBuffer(GL_ARRAY_BUFFER, chunk.portal.vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(chunk.portal.vertices), chunk.portal.vertices, GL_STATIC_DRAW);
-
-	// Bind and upload the EBO
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.portal.ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(chunk.portal.indices), chunk.portal.indices, GL_STATIC_DRAW);
-
-	// Set up the vertex attributes
-	// Position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Texture coordinate attribute
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
+Renderer::~Renderer() {
+	for (auto &entry : portal_targets) {
+		entry.second.destroy();
+	}
+	for (PortalTarget &target : free_portal_targets) {
+		target.destroy();
+	}
+}
 
-	// Unbind the VAO
-	glBindVertexArray(0);
+void Renderer::release_chunk_resources(Chunk &chunk) {
+	arena.release(chunk.chunk_id);
+	auto found = portal_targets.find(chunk.chunk_id);
+	if (found == portal_targets.end()) {
+		return;
+	}
+	if (free_portal_targets.size() < MAX_POOLED_PORTAL_TARGETS) {
+		free_portal_targets.push_back(found->second);
+	}
+	else {
+		found->second.destroy();
+		++portal_targets_deleted;
+	}
+	portal_targets.erase(found);
 }
 
+//every portal's quad is the same and its framebuffer is the screen's size, so any pooled target will do
+const PortalTarget &Renderer::portal_target(const Chunk &chunk) {
+	PortalTarget &target = portal_targets[chunk.chunk_id];
+	if (!target.created()) {
+		if (!free_portal_targets.empty()) {
+			target = free_portal_targets.back();
+			free_portal_targets.pop_back();
+		}
+		else {
+			target.create(chunk.portal);
+			++portal_targets_created;
+		}
+	}
+	return target;
+}
 
 void Renderer::initChunkBuffers(ChunkManager &chunks) {
-	std::lock_guard<std::mutex> lock(chunks.chunk_mutex); // Lock for thread safety
-	for (int i = 0; i < chunks.chunks.size(); ++i) {
-		if (chunks.chunks[i].buffers_initialized == false) {
-			
-			glBindVertexArray(chunks.chunks[i].VertexArrayID);
-			glBindBuffer(GL_ARRAY_BUFFER, chunks.chunks[i].vertex_buffer);
-
-			glBufferData(GL_ARRAY_BUFFER, chunks.chunks[i].vertices.size() * sizeof(float), &chunks.chunks[i].vertices[0], GL_STATIC_DRAW);
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(
-				0,                  // attribute 0. No particular reason for 0, but must match the layout in the shader.
-				3,                 // size
-				GL_FLOAT,           // type
-				GL_FALSE,           // normalized?
-				0,                  // stride
-				(void*)0            // array buffer offset
-			);
+	//chunks belongs to the main thread, which is also the one uploading, so it is read here without a
+	//lock and workers meshing against the BorderSnapshot aren't held up by uploads
+	auto start = std::chrono::steady_clock::now();
+	if (!upload_ring.initialized()) {
+		upload_ring.init();
+	}
+	if (!arena.initialized()) {
+		arena.init();
+	}
+	arena.maintain();
+
+	upload_bytes = 0;
+	upload_chunks = 0;
+	uploads_waiting = 0;
+	for (Chunk &chunk : chunks.chunks) {
+		if (chunk.state != CHUNK_MESHED) {
+			continue;
+		}
+		size_t bytes = chunk.vertices.size() * sizeof(ChunkVertex) + chunk.indices.size() * sizeof(int);
+		if ((upload_chunks > 0 && upload_bytes + bytes > upload_budget_bytes) || !upload_chunk(chunk, chunks)) {
+			++uploads_waiting;
+			continue;
+		}
+		upload_bytes += bytes;
+		++upload_chunks;
+	}
+	upload_ring.end_frame();
 
-			glBindBuffer(GL_ARRAY_BUFFER, chunks.chunks[i].normalBuffer);
-			glBufferData(GL_ARRAY_BUFFER, chunks.chunks[i].normals.size() * sizeof(float), &chunks.chunks[i].normals[0], GL_STATIC_DRAW);
-			glEnableVertexAttribArray(1);
-			glBindBuffer(GL_ARRAY_BUFFER, chunks.chunks[i].normalBuffer);
-			glVertexAttribPointer(
-				1,                                // attribute
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
+	glBindVertexArray(0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	upload_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-			glBindBuffer(GL_ARRAY_BUFFER, chunks.chunks[i].colorBuffer);
-			glBufferData(GL_ARRAY_BUFFER, chunks.chunks[i].colors.size() * sizeof(float), &chunks.chunks[i].colors[0], GL_STATIC_DRAW);
-			glEnableVertexAttribArray(2);
-			glVertexAttribPointer(
-				2,                                // attribute
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
+//stages the chunk's vertices and indices in the ring and copies them into its arena ranges, which are
+//reallocated first if the mesh doesn't fit them. false when the ring has no space this frame
+bool Renderer::upload_chunk(Chunk &chunk, ChunkManager &chunks) {
+	size_t vertex_bytes = chunk.vertices.size() * sizeof(ChunkVertex);
+	size_t index_bytes = chunk.indices.size() * sizeof(int);
+	if (vertex_bytes == 0 || index_bytes == 0) {
+		arena.release(chunk.chunk_id);
+		chunk.state = CHUNK_UPLOADED;	//nothing to draw, the draw list skips it
+		chunks.make_resident(chunk);
+		return true;
+	}
 
-			glBindBuffer(GL_ARRAY_BUFFER, chunks.chunks[i].texture_buffer);
-			glBufferData(GL_ARRAY_BUFFER, chunks.chunks[i].tex_coords.size() * sizeof(float), &chunks.chunks[i].tex_coords[0], GL_STATIC_DRAW);
-			glEnableVertexAttribArray(3);
-			glVertexAttribPointer(
-				3,                                // attribute
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
+	size_t offset = 0;
+	const void *parts[2] = { chunk.vertices.data(), chunk.indices.data() };
+	size_t sizes[2] = { vertex_bytes, index_bytes };
+	bool staged = upload_ring.stage(parts, sizes, 2, offset);
+	if (!staged && vertex_bytes + index_bytes <= upload_ring.capacity()) {
+		return false;
+	}
 
-			glBindBuffer(GL_ARRAY_BUFFER, chunks.chunks[i].tangent_buffer);
-			glBufferData(GL_ARRAY_BUFFER, chunks.chunks[i].tangents.size() * sizeof(float), &chunks.chunks[i].tangents[0], GL_STATIC_DRAW);
-			glEnableVertexAttribArray(4);
-			glVertexAttribPointer(
-				4,                                // attribute
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
+	const ChunkRanges *ranges = arena.reserve(chunk.chunk_id, chunk.vertices.size(), chunk.indices.size());
+	size_t vertex_offset = ranges->vertices.offset * sizeof(ChunkVertex);
+	size_t index_offset = ranges->indices.offset * sizeof(int);
+	if (staged) {
+		upload_ring.copy(offset, arena.vertex_buffer(), vertex_offset, vertex_bytes);
+		upload_ring.copy(offset + vertex_bytes, arena.index_buffer(), index_offset, index_bytes);
+	}
+	else {
+		//bigger than the whole ring, written directly
+		glBindBuffer(GL_COPY_WRITE_BUFFER, arena.vertex_buffer());
+		glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset, vertex_bytes, chunk.vertices.data());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, arena.index_buffer());
+		glBufferSubData(GL_COPY_WRITE_BUFFER, index_offset, index_bytes, chunk.indices.data());
+	}
 
-			glBindBuffer(GL_ARRAY_BUFFER, chunks.chunks[i].bitangent_buffer);
-			glBufferData(GL_ARRAY_BUFFER, chunks.chunks[i].bitangents.size() * sizeof(float), &chunks.chunks[i].bitangents[0], GL_STATIC_DRAW);
-			glEnableVertexAttribArray(5);
-			glVertexAttribPointer(
-				5,                                // attribute
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
+	chunk.state = CHUNK_UPLOADED;
+	chunks.make_resident(chunk);
+	return true;
+}
 
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunks.chunks[i].IndexBuffer);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, chunks.chunks[i].indices.size() * sizeof(int), &chunks.chunks[i].indices[0], GL_STATIC_DRAW);
+void Renderer::build_draw_list(ChunkManager &chunks) {
+	//resident only changes on the main thread, so reading it here needs no lock
+	draw_list.build(chunks.resident, arena);
+}
 
-			glBindVertexArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+void Renderer::cull_chunks(RenderPass pass, const glm::mat4 &view_projection) {
+	draw_list.cull(pass, view_projection);
+}
 
-			//init_chunk_portal_buffers(chunks.chunks[i]);
-			chunks.chunks[i].buffers_initialized = true;
-		}
-	}
-}
\ No newline at end of file
+void Renderer::render_chunks(RenderPass pass) {
+	
+	glEnable(GL_DEPTH_TEST);  // Ensure depth testing is on
+	//glEnable(GL_CULL_FACE);   // Cull back faces for performance
+	//glCullFace(GL_BACK);
+	draw_list.draw(arena, pass);
+}
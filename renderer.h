@@ -1,18 +1,54 @@
 #pragma once
 #include "glad/glad.h"
+#include <iostream>
+#include <unordered_map>
 #include "chunk_manager.h"
+#include "chunk_arena.h"
+#include "chunk_draw_list.h"
+#include "portal_target.h"
+#include "upload_ring.h"
+#include "gpu_profiler.h"
 //#include "chunk.h"
 
-class Renderer {
+//the GL backend of the chunk pipeline. owns every GPU handle the chunks need, keyed by Chunk::chunk_id:
+//their mesh ranges in the arena and their portal framebuffers. main thread only
+class Renderer : public ChunkBackend {
 public:
 
+	static constexpr size_t MAX_POOLED_PORTAL_TARGETS = ChunkManager::MAX_QUEUE_SIZE;
 
 	Renderer() = default;
+	~Renderer();
+	//frees the chunk's arena ranges and pools its portal framebuffer for the next chunk
+	void release_chunk_resources(Chunk &chunk) override;
 	void renderWireframes();
 	void enableDepthTesting();
+	//uploads the meshes of chunks in CHUNK_MESHED into the chunk arena through the upload ring and makes
+	//them resident, until upload_budget_bytes have been uploaded this frame. the rest wait for the next frames
 	void initChunkBuffers(ChunkManager &chunks);
-	void init_chunk_portal_buffers(Chunk &chunk);
+	//collects the resident chunks to draw this frame, call once a frame after the uploads and before the passes
+	void build_draw_list(ChunkManager &chunks);
+	//picks the chunks of the draw list the pass can see, view_projection is the matrix the pass renders with
+	void cull_chunks(RenderPass pass, const glm::mat4 &view_projection);
+	//draws the chunks the pass can see with the currently bound shader. vertex positions are chunk relative,
+	//the shader gets each chunk's world origin through its per instance chunkOrigin attribute
+	void render_chunks(RenderPass pass);
+	//the framebuffer and quad of the chunk's portal, created or taken from the pool the first time
+	const PortalTarget &portal_target(const Chunk &chunk);
 	//void render_portal_view(const Portal &portal);
+
+	ChunkArena arena;						//GPU storage of every loaded chunk's mesh
+	ChunkDrawList draw_list;				//this frame's chunk draws, culled and drawn per render pass
+	GpuProfiler gpu_profiler;				//GPU time of the passes, see PROFILE_GPU_SCOPE
+
+	size_t upload_budget_bytes = 4 * 1024 * 1024;	//per frame, one chunk is always uploaded even if bigger
+	size_t upload_bytes = 0;						//uploaded last frame
+	float upload_ms = 0.0f;							//cpu time initChunkBuffers took last frame
+	int upload_chunks = 0;							//chunks uploaded last frame
+	int uploads_waiting = 0;						//chunks left for later frames
+	size_t portal_targets_created = 0;				//running totals of portal framebuffers created and deleted
+	size_t portal_targets_deleted = 0;
+	size_t pooled_portal_targets() const { return free_portal_targets.size(); }
 	template<typename T>
 	void init_framebuffer(T &obj) {
 		glGenFramebuffers(1, &obj.fbo);
@@ -43,4 +79,12 @@ public:
 		// Unbind the FBO
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
+
+private:
+
+	bool upload_chunk(Chunk &chunk, ChunkManager &chunks);
+
+	UploadRing upload_ring;
+	std::unordered_map<int, PortalTarget> portal_targets;	//by chunk id
+	std::vector<PortalTarget> free_portal_targets;			//of unloaded chunks, reused before creating new ones
 };
\ No newline at end of file
@@ -14,6 +14,7 @@ in vec3 N;
 in vec3 tangentLightDirection;
 in vec4 FragPosLightSpace;
 in vec3 lightPos;
+in float vertexAO;
 
 
 uniform vec3 lightColor;
@@ -104,7 +105,7 @@ void main(){
 	
 	float ambientOcclusion = texture(texture3D, vec3(TexCoords.rg, 3.0)).r; // AO values are in [0,1]
 	vec3 ambientColor = vec3(0.4, 0.3, 0.2); // Soft, neutral ambient light										 
-	vec3 ambient = ambientColor * ambientOcclusion;// Apply AO to ambient and diffuse light
+	vec3 ambient = ambientColor * ambientOcclusion * vertexAO;// Apply AO to ambient and diffuse light
 
 	//vec3 norm = normalize(v_normal);
 	vec3 norm = texture(texture3D, vec3(TexCoords.rg, 1.0)).rgb;
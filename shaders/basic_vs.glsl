@@ -1,11 +1,10 @@
 #version 330 core
 
-layout(location = 0) in vec3 vertexPosition_modelspace;
-layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 color;
-layout(location = 3) in vec3 tex_coords;
-layout(location = 4) in vec3 tangents;
-layout(location = 5) in vec3 bitangents;
+// packed ChunkVertex, see chunk.h for the bit layout
+layout(location = 0) in uint packedPosition;
+layout(location = 1) in uint packedAttributes;
+// world position of the chunk's minimum corner, one per draw
+layout(location = 2) in vec3 chunkOrigin;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -28,23 +27,54 @@ out vec3 tangentFragPos;
 out vec3 tangentLightDirection;
 out vec4 FragPosLightSpace;
 out vec3 lightPos;
+out float vertexAO;
 
 out vec3 T;
 out vec3 B;
 out vec3 N;
 
+// tangent space of each voxel face indexed by CubeFace (front, back, left, right, top, bottom).
+// columns are the tangent (follows u, corner 0 -> 1), bitangent (follows v, corner 1 -> 2) and normal
+const mat3 FACE_TBN[6] = mat3[](
+	mat3(1.0, 0.0, 0.0,   0.0, 1.0, 0.0,   0.0, 0.0, 1.0),
+	mat3(-1.0, 0.0, 0.0,  0.0, 1.0, 0.0,   0.0, 0.0, -1.0),
+	mat3(0.0, 0.0, 1.0,   0.0, 1.0, 0.0,   -1.0, 0.0, 0.0),
+	mat3(0.0, 0.0, -1.0,  0.0, 1.0, 0.0,   1.0, 0.0, 0.0),
+	mat3(1.0, 0.0, 0.0,   0.0, 0.0, -1.0,  0.0, 1.0, 0.0),
+	mat3(1.0, 0.0, 0.0,   0.0, 0.0, 1.0,   0.0, -1.0, 0.0)
+	);
+
+// indexed by BlockType, mirrors block_colors
+const vec3 BLOCK_COLORS[2] = vec3[](
+	vec3(0.5, 0.5, 0.5),
+	vec3(0.0, 0.7, 0.0)
+	);
+
 void main(){
-	
+
+	// block corners are stored relative to the chunk, blocks are centred on integer coordinates
+	vec3 corner = vec3(packedPosition & 1023u, (packedPosition >> 10) & 1023u, (packedPosition >> 20) & 1023u);
+	vec3 vertexPosition_modelspace = corner - 0.5 + chunkOrigin;
+
+	uint face = packedAttributes & 7u;
+	vec2 uv = vec2((packedAttributes >> 3) & 63u, (packedAttributes >> 9) & 63u);
+	uint blockType = (packedAttributes >> 15) & 255u;
+	vertexAO = float((packedAttributes >> 23) & 3u) / 3.0;
+
+	mat3 faceTBN = FACE_TBN[face];
+	vec3 normal = faceTBN[2];
+
 	fragPos = vec3(model * vec4(vertexPosition_modelspace, 1.0));
 	FragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0);
-	fragmentColor = color;
-	mat3 normalMatrix = transpose(inverse(mat3(model)));
+	fragmentColor = BLOCK_COLORS[min(blockType, 1u)];
 	v_normal = normal;
-	TexCoords = tex_coords;
-	T = normalize(vec3(model * vec4(tangents, 0.0)));
-	B = normalize(vec3(model * vec4(bitangents, 0.0)));
-	N = normalize(vec3(model * vec4(normal, 0.0)));
-	mat3 TBN = transpose(mat3(T, B, N));
+	TexCoords = vec3(uv, 0.0);
+	// chunks are only ever translated, so the face frame stays orthonormal under the model matrix
+	mat3 modelTBN = mat3(model) * faceTBN;
+	T = modelTBN[0];
+	B = modelTBN[1];
+	N = modelTBN[2];
+	mat3 TBN = transpose(modelTBN);
 	tangentLightDirection = TBN * normalize(-lightDirection);
 	tangentLightPos = TBN * lightPosition;
 	tangentViewPos = TBN * viewPos;
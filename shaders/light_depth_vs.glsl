@@ -1,10 +1,14 @@
 #version 330 core
-layout(location = 0) in vec3 aPos;
+// packed ChunkVertex position, see chunk.h
+layout(location = 0) in uint packedPosition;
+// world position of the chunk's minimum corner, one per draw
+layout(location = 2) in vec3 chunkOrigin;
 
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
 void main()
 {
+	vec3 aPos = vec3(packedPosition & 1023u, (packedPosition >> 10) & 1023u, (packedPosition >> 20) & 1023u) - 0.5 + chunkOrigin;
 	gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+//ArenaAllocator's bookkeeping, which is GL-free, against a CPU buffer standing in for the GPU one
+#include "test.h"
+#include "../arena_allocator.h"
+#include <cstring>
+
+TEST(arena, allocate_and_free) {
+	ArenaAllocator arena(100);
+	ArenaRange a, b, c;
+	CHECK(arena.allocate(10, a));
+	CHECK(arena.allocate(20, b));
+	CHECK(arena.allocate(30, c));
+	CHECK_EQ(a.offset, 0);
+	CHECK_EQ(b.offset, 10);
+	CHECK_EQ(c.offset, 30);
+	CHECK_EQ(arena.used(), 60);
+	CHECK_EQ(arena.largest_free(), 40);
+
+	//too big or empty requests fail and leave the range alone
+	ArenaRange d = { 7, 3 };
+	CHECK(!arena.allocate(41, d));
+	CHECK(!arena.allocate(0, d));
+	CHECK_EQ(d.offset, 7);
+	CHECK_EQ(d.size, 3);
+
+	arena.free(b);
+	CHECK_EQ(b.size, 0);
+	CHECK_EQ(arena.used(), 40);
+	arena.free(b);		//freeing an empty range does nothing
+	CHECK_EQ(arena.used(), 40);
+
+	//first fit takes the hole b left before the space at the end
+	CHECK(arena.allocate(15, d));
+	CHECK_EQ(d.offset, 10);
+}
+
+TEST(arena, coalesces_free_neighbours) {
+	ArenaAllocator arena(100);
+	ArenaRange a, b, c;
+	arena.allocate(10, a);
+	arena.allocate(10, b);
+	arena.allocate(10, c);
+	CHECK_EQ(arena.free_blocks(), 1);
+	arena.free(a);
+	CHECK_EQ(arena.free_blocks(), 2);		//a's block and the end
+	arena.free(c);
+	CHECK_EQ(arena.free_blocks(), 2);		//c merged into the end
+	CHECK_EQ(arena.largest_free(), 80);
+	arena.free(b);
+	CHECK_EQ(arena.free_blocks(), 1);		//b joins both sides
+	CHECK_EQ(arena.largest_free(), 100);
+	CHECK_EQ(arena.used(), 0);
+	CHECK(arena.fragmentation() == 0.0f);
+}
+
+TEST(arena, compacts_a_fragmented_arena) {
+	const int count = 20, size = 5;
+	ArenaAllocator arena(count * size);
+	ArenaRange ranges[count];
+	std::vector<int> buffer(count * size, -1);
+	for (int i = 0; i < count; ++i) {
+		CHECK(arena.allocate(size, ranges[i]));
+		std::fill(buffer.begin() + ranges[i].offset, buffer.begin() + ranges[i].offset + size, i);
+	}
+	CHECK(!arena.allocate(1, ranges[0]));
+
+	//every other range freed leaves ten holes of 5, half the arena free and nothing of 10 fits
+	std::vector<ArenaRange *> live;
+	for (int i = 0; i < count; ++i) {
+		if (i % 2 == 0) {
+			arena.free(ranges[i]);
+		}
+		else {
+			live.push_back(&ranges[i]);
+		}
+	}
+	CHECK_EQ(arena.free_blocks(), count / 2);
+	CHECK_EQ(arena.largest_free(), size);
+	CHECK(arena.fragmentation() > 0.85f);
+	ArenaRange big;
+	CHECK(!arena.allocate(2 * size, big));
+
+	//the moves copy the contents in order, each to an offset no higher than where it came from
+	std::vector<ArenaMove> moves = arena.compact(live);
+	CHECK_EQ(moves.size(), live.size());
+	for (const ArenaMove &move : moves) {
+		CHECK(move.new_offset <= move.old_offset);
+		std::memmove(&buffer[move.new_offset], &buffer[move.old_offset], move.size * sizeof(int));
+	}
+	size_t end = 0;
+	for (int i = 1; i < count; i += 2) {
+		CHECK_EQ(ranges[i].offset, end);
+		CHECK_EQ(ranges[i].size, size);
+		for (size_t k = 0; k < (size_t)size; ++k) {
+			CHECK_EQ(buffer[ranges[i].offset + k], i);
+		}
+		end += size;
+	}
+	CHECK_EQ(arena.used(), count / 2 * size);
+	CHECK_EQ(arena.free_blocks(), 1);
+	CHECK_EQ(arena.largest_free(), count / 2 * size);
+	CHECK(arena.fragmentation() == 0.0f);
+	CHECK(arena.allocate(2 * size, big));
+	CHECK_EQ(big.offset, end);
+}
+
+TEST(arena, grows) {
+	ArenaAllocator arena;
+	ArenaRange a, b, c;
+	CHECK(!arena.allocate(1, a));
+	arena.grow(50);
+	CHECK_EQ(arena.capacity(), 50);
+	CHECK(arena.allocate(30, a));
+
+	//the free space at the end is extended rather than a second block added
+	arena.grow(80);
+	CHECK_EQ(arena.free_blocks(), 1);
+	CHECK_EQ(arena.largest_free(), 50);
+	CHECK(arena.allocate(50, b));
+	CHECK_EQ(b.offset, 30);
+
+	//a full arena gets a new block at the old end
+	arena.grow(100);
+	CHECK_EQ(arena.free_blocks(), 1);
+	CHECK(arena.allocate(20, c));
+	CHECK_EQ(c.offset, 80);
+
+	//shrinking is ignored
+	arena.grow(10);
+	CHECK_EQ(arena.capacity(), 100);
+	arena.free(b);
+	arena.free(a);
+	CHECK_EQ(arena.free_blocks(), 1);
+	CHECK_EQ(arena.largest_free(), 80);
+}
@@ -0,0 +1,81 @@
+//ChunkCuller against known frusta. the boxes have to hold the geometry where basic_vs.glsl puts it, half a
+//block below the block coordinates, or chunks at the edge of the screen are culled while partly visible
+#include "test.h"
+#include "../chunk_culler.h"
+#include "../chunk.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <memory>
+
+//a chunk at the given world origin with stone at each block, meshed and bounded as STAGE_MESH does
+static std::unique_ptr<Chunk> chunk_with(const std::vector<glm::ivec3> &blocks) {
+	std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(0, 0);
+	chunk->blocks.fill_box(0, 0, 0, Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE, INACTIVE);
+	for (const glm::ivec3 &b : blocks) {
+		chunk->blocks.set(b.x, b.y, b.z, STONE);
+	}
+	chunk->generate_mesh(MESH_CULLED, ChunkBorders());
+	chunk->compute_mesh_bounds();
+	return chunk;
+}
+
+//an orthographic view down -z of x in [left, right] and y in [bottom, top], every z from -100 to 100
+static glm::mat4 box_view(float left, float right, float bottom, float top) {
+	return glm::ortho(left, right, bottom, top, -100.0f, 100.0f);
+}
+
+static bool visible(const Chunk &chunk, const glm::vec3 &origin, const glm::mat4 &view_projection) {
+	ChunkCuller culler;
+	culler.add(origin, chunk.mesh_min, chunk.mesh_max, chunk.mesh_sections);
+	std::vector<uint32_t> result;
+	culler.cull(view_projection, result);
+	return result.size() == 1 && result[0] == 0;
+}
+
+TEST(culling, box_holds_the_geometry_as_drawn) {
+	//the block at 0, 0, 0 is drawn over -0.5 to 0.5 on every axis
+	std::unique_ptr<Chunk> chunk = chunk_with({ glm::ivec3(0, 0, 0) });
+	ChunkCuller culler;
+	culler.add(glm::vec3(64.0f, 0.0f, 32.0f), chunk->mesh_min, chunk->mesh_max, chunk->mesh_sections);
+	CHECK(culler.box_min(0) == glm::vec3(63.5f, -0.5f, 31.5f));
+	CHECK(culler.box_max(0) == glm::vec3(64.5f, 0.5f, 32.5f));
+}
+
+TEST(culling, chunk_at_the_frustum_edge) {
+	std::unique_ptr<Chunk> chunk = chunk_with({ glm::ivec3(0, 0, 0) });
+	glm::vec3 origin(0.0f);
+	//the view ends at x = -0.2, inside the block's min side: drawn in part, so it has to stay
+	CHECK(visible(*chunk, origin, box_view(-10.0f, -0.2f, -10.0f, 10.0f)));
+	//the view starts at x = 0.7, past the block's max side at 0.5: nothing of it is on screen
+	CHECK(!visible(*chunk, origin, box_view(0.7f, 10.0f, -10.0f, 10.0f)));
+	//the same on y and on z, through the top and the near plane
+	CHECK(visible(*chunk, origin, box_view(-10.0f, 10.0f, -10.0f, -0.3f)));
+	CHECK(!visible(*chunk, origin, box_view(-10.0f, 10.0f, 0.6f, 10.0f)));
+	CHECK(visible(*chunk, origin, glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.3f, 100.0f)));	//z <= -0.3
+	CHECK(!visible(*chunk, origin, glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, -100.0f, -0.6f)));	//z >= 0.6
+}
+
+TEST(culling, section_at_the_frustum_edge) {
+	//one block high up at x = 0 and one low at x = 16, in sections (0, 3, 0) and (2, 0, 0). the view takes
+	//in the low block's min side only, so the chunk's box crosses the frustum and its sections decide
+	std::unique_ptr<Chunk> chunk = chunk_with({ glm::ivec3(0, 24, 0), glm::ivec3(16, 0, 0) });
+	CHECK(chunk->mesh_sections == ((1ull << ((0 * 4 + 3) * 4 + 0)) | (1ull << ((2 * 4 + 0) * 4 + 0))));
+	glm::vec3 origin(0.0f);
+	CHECK(visible(*chunk, origin, box_view(-10.0f, 15.7f, -10.0f, 10.0f)));
+	//moved past the low block's min side nothing is left
+	CHECK(!visible(*chunk, origin, box_view(-10.0f, 15.3f, -10.0f, 10.0f)));
+}
+
+TEST(culling, perspective_camera) {
+	//a camera in the middle of a row of chunks along x, looking along +x with a 90 degree field of view
+	std::unique_ptr<Chunk> chunk = chunk_with({ glm::ivec3(16, 16, 16) });
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 500.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 16.0f, 16.0f), glm::vec3(1.0f, 16.0f, 16.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	ChunkCuller culler;
+	for (int i = -4; i < 4; ++i) {
+		culler.add(glm::vec3(i * 32.0f, 0.0f, 0.0f), chunk->mesh_min, chunk->mesh_max, chunk->mesh_sections);
+	}
+	std::vector<uint32_t> result;
+	culler.cull(projection * view, result);
+	//the blocks of the chunks at x = 0, 32, 64 and 96 are in front, the ones behind are culled
+	CHECK(result == std::vector<uint32_t>({ 4, 5, 6, 7 }));
+}
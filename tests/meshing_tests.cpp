@@ -0,0 +1,251 @@
+//face counts of the meshers on small fixed block layouts, no GL needed
+#include "test.h"
+#include "../chunk.h"
+#include <memory>
+
+static const int N = 32;	//Chunk::CHUNK_SIZE, a constant here so layouts can be written as expressions
+
+//an all air chunk to place blocks in
+static std::unique_ptr<Chunk> air_chunk() {
+	std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(0, 0);
+	chunk->blocks.fill_box(0, 0, 0, N, N, N, INACTIVE);
+	return chunk;
+}
+
+static size_t faces(const Chunk &chunk) {
+	return chunk.indices.size() / 6;
+}
+
+//every side of a loaded neighbour made of one type
+static ChunkBorders uniform_borders(BlockType type) {
+	ChunkBorders borders;
+	for (std::vector<BlockType> &side : borders.sides) {
+		side.assign(N * N, type);
+	}
+	return borders;
+}
+
+TEST(meshing, culled_single_block) {
+	std::unique_ptr<Chunk> chunk = air_chunk();
+	chunk->blocks.set(5, 5, 5, STONE);
+	chunk->generate_mesh(MESH_CULLED, ChunkBorders());
+	CHECK_EQ(faces(*chunk), 6);
+	CHECK_EQ(chunk->vertices.size(), 24);
+	CHECK_EQ(chunk->block_number, 1);
+}
+
+TEST(meshing, culled_two_adjacent_blocks) {
+	std::unique_ptr<Chunk> chunk = air_chunk();
+	chunk->blocks.set(5, 5, 5, STONE);
+	chunk->blocks.set(6, 5, 5, GRASS);
+	chunk->generate_mesh(MESH_CULLED, ChunkBorders());
+	//the two touching faces are buried whatever the types
+	CHECK_EQ(faces(*chunk), 10);
+	CHECK_EQ(chunk->block_number, 2);
+
+	//the same pair straddling two sections
+	chunk = air_chunk();
+	chunk->blocks.set(7, 5, 5, STONE);
+	chunk->blocks.set(8, 5, 5, STONE);
+	chunk->generate_mesh(MESH_CULLED, ChunkBorders());
+	CHECK_EQ(faces(*chunk), 10);
+}
+
+TEST(meshing, culled_full_chunk) {
+	std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(0, 0);	//reset fills it with stone
+	chunk->generate_mesh(MESH_CULLED, ChunkBorders());
+	//no neighbours loaded, every outside face shows
+	CHECK_EQ(faces(*chunk), 6 * N * N);
+
+	//solid neighbours on all four sides leave the top and the bottom
+	chunk->generate_mesh(MESH_CULLED, uniform_borders(STONE));
+	CHECK_EQ(faces(*chunk), 2 * N * N);
+
+	//air neighbours hide nothing
+	chunk->generate_mesh(MESH_CULLED, uniform_borders(INACTIVE));
+	CHECK_EQ(faces(*chunk), 6 * N * N);
+}
+
+TEST(meshing, culled_block_on_border) {
+	std::unique_ptr<Chunk> chunk = air_chunk();
+	chunk->blocks.set(0, 3, 4, STONE);
+	chunk->generate_mesh(MESH_CULLED, ChunkBorders());
+	CHECK_EQ(faces(*chunk), 6);
+
+	//a solid block in the neighbour on the -x side buries the left face only
+	ChunkBorders borders;
+	borders.sides[FACE_LEFT].assign(N * N, INACTIVE);
+	borders.sides[FACE_LEFT][4 * N + 3] = STONE;
+	chunk->generate_mesh(MESH_CULLED, borders);
+	CHECK_EQ(faces(*chunk), 5);
+
+	//the neighbour's block at another height doesn't
+	borders.sides[FACE_LEFT][4 * N + 3] = INACTIVE;
+	borders.sides[FACE_LEFT][4 * N + 2] = STONE;
+	chunk->generate_mesh(MESH_CULLED, borders);
+	CHECK_EQ(faces(*chunk), 6);
+}
+
+TEST(meshing, culled_matches_naive_when_nothing_touches) {
+	//isolated blocks on a grid two apart have no buried faces, so culling keeps every naive face
+	std::unique_ptr<Chunk> chunk = air_chunk();
+	int blocks = 0;
+	for (int x = 1; x < N; x += 2) {
+		for (int y = 1; y < N; y += 2) {
+			for (int z = 1; z < N; z += 2) {
+				chunk->blocks.set(x, y, z, (x + z) % 4 == 2 ? GRASS : STONE);
+				++blocks;
+			}
+		}
+	}
+	chunk->generate_mesh(MESH_NAIVE, ChunkBorders());
+	size_t naive = faces(*chunk);
+	chunk->generate_mesh(MESH_CULLED, ChunkBorders());
+	CHECK_EQ(naive, 6 * blocks);
+	CHECK_EQ(faces(*chunk), naive);
+}
+
+//a layout as a function of block coordinates, which may lie just outside the chunk for its borders
+typedef BlockType (*Layout)(int x, int y, int z);
+
+static BlockType checkerboard(int x, int y, int z) {
+	return ((x + y + z) & 1) ? INACTIVE : STONE;
+}
+
+//stone below 10, a grass layer on top with a few holes, air above it, a stone pillar and an air pocket
+static BlockType mixed(int x, int y, int z) {
+	if (x >= 12 && x < 15 && z >= 4 && z < 6 && y < 20) {
+		return STONE;
+	}
+	if (x >= 20 && x < 24 && y >= 3 && y < 6 && z >= 8 && z < 16) {
+		return INACTIVE;
+	}
+	if (y < 10) {
+		return STONE;
+	}
+	if (y == 10) {
+		return (x * 7 + z * 3) % 11 == 0 ? INACTIVE : GRASS;
+	}
+	return INACTIVE;
+}
+
+static std::unique_ptr<Chunk> layout_chunk(Layout layout) {
+	std::unique_ptr<Chunk> chunk = air_chunk();
+	for (int x = 0; x < N; ++x) {
+		for (int y = 0; y < N; ++y) {
+			for (int z = 0; z < N; ++z) {
+				chunk->blocks.set(x, y, z, layout(x, y, z));
+			}
+		}
+	}
+	chunk->blocks.compact();
+	return chunk;
+}
+
+//the sides of the four neighbours as the layout continues into them
+static ChunkBorders layout_borders(Layout layout) {
+	ChunkBorders borders;
+	for (int face = FACE_FRONT; face <= FACE_RIGHT; ++face) {
+		std::vector<BlockType> &side = borders.sides[face];
+		side.resize(N * N);
+		for (int a = 0; a < N; ++a) {
+			for (int y = 0; y < N; ++y) {
+				switch (face) {
+				case FACE_FRONT: side[a * N + y] = layout(a, y, N); break;
+				case FACE_BACK:  side[a * N + y] = layout(a, y, -1); break;
+				case FACE_LEFT:  side[a * N + y] = layout(-1, y, a); break;
+				default:         side[a * N + y] = layout(N, y, a); break;
+				}
+			}
+		}
+	}
+	return borders;
+}
+
+//blocks covered by the mesh's quads for every CubeFace and BlockType, from the uv size of each quad's
+//third corner, which greedy quads stretch over the blocks they merge
+static std::vector<size_t> surface_area(const Chunk &chunk) {
+	std::vector<size_t> area(6 * 256, 0);
+	for (size_t quad = 0; quad + 3 < chunk.vertices.size(); quad += 4) {
+		uint32_t attributes = chunk.vertices[quad + 2].attributes;
+		uint32_t face = attributes & 7u, type = (attributes >> 15) & 255u;
+		uint32_t u = (attributes >> 3) & 63u, v = (attributes >> 9) & 63u;
+		area[face * 256 + type] += u * v;
+	}
+	return area;
+}
+
+static size_t total(const std::vector<size_t> &area) {
+	size_t sum = 0;
+	for (size_t a : area) {
+		sum += a;
+	}
+	return sum;
+}
+
+//greedy has to cover exactly the culled faces, per face direction and block type, in no more quads
+static void check_greedy_covers_culled(Chunk &chunk, const ChunkBorders &borders) {
+	chunk.generate_mesh(MESH_CULLED, borders);
+	size_t culled_faces = faces(chunk);
+	std::vector<size_t> culled = surface_area(chunk);
+	chunk.generate_mesh(MESH_GREEDY, borders);
+	std::vector<size_t> greedy = surface_area(chunk);
+	CHECK_EQ(total(culled), culled_faces);
+	CHECK_EQ(total(greedy), culled_faces);
+	CHECK(greedy == culled);
+	CHECK(faces(chunk) <= culled_faces);
+}
+
+TEST(meshing, greedy_uniform_chunk) {
+	std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(0, 0);
+	check_greedy_covers_culled(*chunk, ChunkBorders());
+	CHECK_EQ(faces(*chunk), 6);
+	check_greedy_covers_culled(*chunk, uniform_borders(STONE));
+	CHECK_EQ(faces(*chunk), 2);
+	CHECK_EQ(total(surface_area(*chunk)), 2 * N * N);
+}
+
+TEST(meshing, greedy_checkerboard_chunk) {
+	//no two visible faces of a checkerboard share an edge, nothing can be merged
+	std::unique_ptr<Chunk> chunk = layout_chunk(checkerboard);
+	const size_t every_face = 6 * (N * N * N / 2);
+	check_greedy_covers_culled(*chunk, ChunkBorders());
+	CHECK_EQ(faces(*chunk), every_face);
+	check_greedy_covers_culled(*chunk, layout_borders(checkerboard));
+	CHECK_EQ(faces(*chunk), every_face);
+}
+
+TEST(meshing, greedy_mixed_chunk) {
+	std::unique_ptr<Chunk> chunk = layout_chunk(mixed);
+	check_greedy_covers_culled(*chunk, ChunkBorders());
+	size_t without_borders = total(surface_area(*chunk));
+	check_greedy_covers_culled(*chunk, layout_borders(mixed));
+	//the neighbours bury the sides of the stone and grass that continue into them
+	CHECK(total(surface_area(*chunk)) < without_borders);
+}
+
+TEST(meshing, for_each_section_matches_get) {
+	BlockStorage blocks;
+	blocks.reset(N, STONE);
+	blocks.fill_box(8, 0, 0, 16, 8, 8, INACTIVE);		//a whole section of air
+	blocks.set(1, 2, 3, GRASS);							//1 bit section
+	for (int i = 0; i < 8; ++i) {
+		blocks.set(16 + i, i, 0, GRASS);				//2 bit section
+		blocks.set(16 + i, 0, i, INACTIVE);
+	}
+
+	const int S = BlockStorage::SECTION_SIZE;
+	int sections = 0, uniform = 0, mismatches = 0;
+	blocks.for_each_section([&](int sx, int sy, int sz, BlockType uniform_type, const BlockType *types) {
+		++sections;
+		uniform += types == nullptr;
+		for (int i = 0; i < BlockStorage::SECTION_VOLUME; ++i) {
+			int lx = i / (S * S), ly = (i / S) % S, lz = i % S;
+			BlockType type = types ? types[i] : uniform_type;
+			mismatches += type != blocks.get(sx * S + lx, sy * S + ly, sz * S + lz);
+		}
+	});
+	CHECK_EQ(sections, (N / S) * (N / S) * (N / S));
+	CHECK_EQ(uniform, sections - 2);
+	CHECK_EQ(mismatches, 0);
+}
@@ -0,0 +1,129 @@
+//the chunk pipeline without a renderer: requests, the worker pool, the hand over to the main thread and
+//residency. the upload is replaced by making every meshed chunk resident, as in voxelite_bench
+#include "test.h"
+#include "../chunk_manager.h"
+#include "../bench/camera_path.h"
+#include <chrono>
+#include <thread>
+
+static const glm::vec3 START = CameraPath::start();
+
+//RENDER_DISTANCE is static, every test sets its own and puts the old one back
+struct RenderDistance {
+	int previous;
+	explicit RenderDistance(int distance) : previous(ChunkManager::RENDER_DISTANCE) { ChunkManager::RENDER_DISTANCE = distance; }
+	~RenderDistance() { ChunkManager::RENDER_DISTANCE = previous; }
+};
+
+//one iteration of voxelite's main loop without the rendering
+static void frame(ChunkManager &manager, glm::vec3 position) {
+	int x = (int)(position.x / ChunkManager::CHUNK_SIZE);
+	int z = (int)(position.z / ChunkManager::CHUNK_SIZE);
+	if (manager.last_x_chunk != x || manager.last_z_chunk != z) {
+		manager.update_visible_chunks(position);
+	}
+	manager.add_pending_chunks();
+	manager.remove_unload_chunks();
+	for (Chunk &chunk : manager.chunks) {
+		if (chunk.state == CHUNK_MESHED) {
+			chunk.state = CHUNK_UPLOADED;
+			manager.make_resident(chunk);
+		}
+	}
+}
+
+static bool idle(ChunkManager &manager) {
+	{
+		std::lock_guard<std::mutex> lock(manager.task_mutex);
+		if (manager.tasks_in_flight != 0 || !manager.chunks_to_load.empty() || manager.ready_chunks.size() != 0 || !manager.unload_list.empty()) {
+			return false;
+		}
+	}
+	for (Chunk &chunk : manager.chunks) {
+		if (chunk.state != CHUNK_RESIDENT) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//runs frames at position until nothing is left to do, false if that takes longer than timeout_seconds
+static bool drain(ChunkManager &manager, glm::vec3 position, double timeout_seconds = 30.0) {
+	auto start = std::chrono::steady_clock::now();
+	do {
+		frame(manager, position);
+		if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout_seconds) {
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	} while (!idle(manager));
+	return true;
+}
+
+//every chunk loaded is within RENDER_DISTANCE of the chunk at position, resident and in the resident list
+static void check_loaded_around(ChunkManager &manager, glm::vec3 position) {
+	int x = (int)(position.x / ChunkManager::CHUNK_SIZE);
+	int z = (int)(position.z / ChunkManager::CHUNK_SIZE);
+	int side = 2 * ChunkManager::RENDER_DISTANCE + 1;
+	CHECK_EQ(manager.chunks.size(), side * side);
+	CHECK_EQ(manager.resident.size(), side * side);
+	for (Chunk &chunk : manager.chunks) {
+		CHECK(std::abs(chunk.chunk_world_xposition - x) <= ChunkManager::RENDER_DISTANCE);
+		CHECK(std::abs(chunk.chunk_world_zposition - z) <= ChunkManager::RENDER_DISTANCE);
+		CHECK(chunk.state == CHUNK_RESIDENT);
+		CHECK(chunk.resident_index >= 0 && manager.resident[chunk.resident_index] == &chunk);
+	}
+}
+
+TEST(pipeline, loads_every_chunk_in_range) {
+	RenderDistance distance(2);
+	ChunkManager manager(START, 2, 7, "");
+	CHECK(drain(manager, START));
+	check_loaded_around(manager, START);
+}
+
+TEST(pipeline, drops_chunks_that_arrive_out_of_range) {
+	RenderDistance distance(2);
+	ChunkManager manager(START, 1, 7, "");
+	//requests the chunks around START and moves away for good before they're finished
+	frame(manager, START);
+	glm::vec3 far = START + glm::vec3(40.0f * ChunkManager::CHUNK_SIZE, 0.0f, 0.0f);
+	CHECK(drain(manager, far));
+	check_loaded_around(manager, far);
+	CHECK(manager.chunks_dropped + manager.chunks_unloaded > 0);
+	CHECK(manager.chunks_to_load_list.size() == manager.chunks.size());
+}
+
+//drives a bench path through the pipeline as fast as the main thread can go, so requests, unloads and late
+//arrivals overlap as much as possible, switching the meshing mode the workers read every 100 frames. meant to
+//be run under ThreadSanitizer (VOXELITE_TSAN), which fails the test on any data race it sees. the mesh cache
+//is switched on so the workers' fetches race the main thread's stores
+static void stress(const char *path_name, int frames, float speed) {
+	RenderDistance distance(3);
+	ChunkManager manager(START, 4, 7, "");
+	manager.mesh_cache.enabled = true;
+	CameraPath path(path_name, frames, speed, 7);
+	const MeshingMode modes[3] = { MESH_GREEDY, MESH_CULLED, MESH_NAIVE };
+	for (int f = 0; f < frames; ++f) {
+		frame(manager, path.at(f));
+		manager.update_telemetry(0.016f);
+		if (f % 100 == 99) {
+			manager.meshing_mode = modes[(f / 100) % 3];
+		}
+		//the borders are published at most once a frame, the workers mesh against whichever they took
+		CHECK(manager.border_publishes <= (size_t)f + 1);
+	}
+	CHECK(drain(manager, path.position));
+	check_loaded_around(manager, path.position);
+	CHECK(manager.chunks_unloaded + manager.chunks_dropped > 0);
+	CHECK_EQ(manager.chunks_to_load_list.size(), manager.chunks.size());
+	CHECK_EQ(manager.staged_borders.size(), manager.chunks.size());
+}
+
+TEST(stress, walk) {
+	stress("walk", 720, 4.0f);
+}
+
+TEST(stress, teleport) {
+	stress("teleport", 960, 0.0f);
+}
@@ -0,0 +1,82 @@
+//region files written to and read back from a scratch directory
+#include "test.h"
+#include "../region_file.h"
+#include <filesystem>
+#include <memory>
+
+static std::string scratch_directory() {
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "voxelite_region_tests";
+	std::filesystem::remove_all(path);
+	return path.string();
+}
+
+TEST(region, keeps_a_bounded_number_of_regions_mapped) {
+	const int R = RegionStore::REGION_SIZE;
+	const int regions = (int)RegionStore::MAX_MAPPED_REGIONS + 4;
+	std::string directory = scratch_directory();
+	{
+		RegionStore store;
+		CHECK(store.open(directory));
+
+		//one chunk in each of a row of regions, with a block to tell them apart
+		for (int r = 0; r < regions; ++r) {
+			std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(r * R, 0);
+			chunk->blocks.set(r, 0, 0, GRASS);
+			store.save(*chunk);
+		}
+		store.flush();
+
+		int loaded = 0, matching = 0;
+		for (int r = 0; r < regions; ++r) {
+			std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(0, 0);
+			loaded += store.load(r * R, 0, *chunk);
+			matching += chunk->blocks.get(r, 0, 0) == GRASS;
+			CHECK(store.mapped_regions() <= RegionStore::MAX_MAPPED_REGIONS);
+		}
+		CHECK_EQ(loaded, regions);
+		CHECK_EQ(matching, regions);
+		CHECK_EQ(store.mapped_regions(), RegionStore::MAX_MAPPED_REGIONS);
+		CHECK_EQ(store.unmaps, regions - RegionStore::MAX_MAPPED_REGIONS);
+
+		//the first region was the least recently used and got unmapped, loading from it maps it again
+		std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(0, 0);
+		CHECK(store.load(0, 0, *chunk));
+		CHECK(chunk->blocks.get(0, 0, 0) == GRASS);
+		CHECK_EQ(store.mapped_regions(), RegionStore::MAX_MAPPED_REGIONS);
+	}
+	std::filesystem::remove_all(directory);
+}
+
+//a payload by hand: a zeroed room, then a 32^3 BlockStorage whose first section is 2 bits a block with a
+//palette of three types and every other section uniform stone. the first block's index is first_index
+static std::vector<uint8_t> payload_with_index(uint8_t first_index) {
+	std::vector<uint8_t> payload(9 * 4, 0);
+	payload.push_back(5);		//log2 of the chunk size
+	payload.push_back(2);
+	payload.push_back(3);
+	payload.push_back(STONE);
+	payload.push_back(GRASS);
+	payload.push_back(INACTIVE);
+	size_t words = payload.size();
+	payload.resize(words + BlockStorage::SECTION_VOLUME * 2 / 8, 0);
+	payload[words] = first_index;
+	for (int s = 1; s < 4 * 4 * 4; ++s) {
+		payload.push_back(0);
+		payload.push_back(1);
+		payload.push_back(STONE);
+	}
+	return payload;
+}
+
+TEST(region, rejects_a_block_outside_its_palette) {
+	std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(0, 0);
+	std::vector<uint8_t> payload = payload_with_index(2);
+	CHECK(RegionStore::decode_chunk(payload.data(), payload.size(), *chunk));
+	CHECK(chunk->blocks.get(0, 0, 0) == INACTIVE);
+
+	//index 3 is past the three entry palette
+	payload = payload_with_index(3);
+	CHECK(!RegionStore::decode_chunk(payload.data(), payload.size(), *chunk));
+	BlockType type;
+	CHECK(chunk->blocks.is_uniform(type) && type == STONE);
+}
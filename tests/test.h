@@ -0,0 +1,46 @@
+#ifndef VOXELITE_TEST_H
+#define VOXELITE_TEST_H
+
+#include <cstdio>
+#include <vector>
+
+//a minimal test registry for voxelite_tests, GL-free like voxelite_core. every TEST registers itself
+//in a group, ctest runs one group per add_test and CHECK failures are counted rather than aborting so a
+//run reports all of them
+
+typedef void (*TestFunction)();
+
+struct TestCase {
+	const char *group;
+	const char *name;
+	TestFunction function;
+};
+
+std::vector<TestCase> &test_cases();
+void test_failed(const char *file, int line, const char *expression);
+
+struct TestRegistration {
+	TestRegistration(const char *group, const char *name, TestFunction function) {
+		test_cases().push_back({ group, name, function });
+	}
+};
+
+#define TEST(group, name) \
+	static void test_##group##_##name(); \
+	static TestRegistration registration_##group##_##name(#group, #name, test_##group##_##name); \
+	static void test_##group##_##name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) test_failed(__FILE__, __LINE__, #expression); } while (0)
+
+//compares as long long so the values can be printed whatever integer type they are
+#define CHECK_EQ(actual, expected) \
+	do { \
+		long long actual_value = (long long)(actual), expected_value = (long long)(expected); \
+		if (actual_value != expected_value) { \
+			std::printf("  %s == %lld, expected %lld\n", #actual, actual_value, expected_value); \
+			test_failed(__FILE__, __LINE__, #actual " == " #expected); \
+		} \
+	} while (0)
+
+#endif // !VOXELITE_TEST_H
@@ -0,0 +1,41 @@
+//runs the registered tests, all of them or only the groups named on the command line. exits non-zero
+//when a check failed or a named group has no tests
+//
+//usage: voxelite_tests [GROUP...]
+#include "test.h"
+#include <cstring>
+#include <string>
+
+static int failures = 0;
+
+std::vector<TestCase> &test_cases() {
+	static std::vector<TestCase> cases;
+	return cases;
+}
+
+void test_failed(const char *file, int line, const char *expression) {
+	std::printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+	++failures;
+}
+
+int main(int argc, char **argv) {
+	int run = 0, failed = 0;
+	for (const TestCase &test : test_cases()) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc && !selected; ++i) {
+			selected = !std::strcmp(argv[i], test.group);
+		}
+		if (!selected) {
+			continue;
+		}
+		int before = failures;
+		std::printf("%s.%s\n", test.group, test.name);
+		test.function();
+		++run;
+		if (failures != before) {
+			++failed;
+		}
+	}
+	std::printf("%d tests, %d failed\n", run, failed);
+	return run == 0 || failed ? 1 : 0;
+}
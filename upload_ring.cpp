@@ -0,0 +1,90 @@
+#include "upload_ring.h"
+#include <cstring>
+#include <cstdint>
+
+static const size_t STAGE_ALIGNMENT = 16;
+
+UploadRing::~UploadRing() {
+	for (Span &span : in_flight) {
+		glDeleteSync(span.fence);
+	}
+	if (buffer) {
+		glDeleteBuffers(1, &buffer);
+	}
+}
+
+void UploadRing::init(size_t capacity) {
+	ring_capacity = capacity;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glBufferData(GL_COPY_READ_BUFFER, ring_capacity, nullptr, GL_STREAM_DRAW);
+}
+
+bool UploadRing::stage(const void *const *parts, const size_t *sizes, int part_count, size_t &offset) {
+	size_t size = 0;
+	for (int i = 0; i < part_count; ++i) {
+		size += sizes[i];
+	}
+	size = (size + STAGE_ALIGNMENT - 1) & ~(STAGE_ALIGNMENT - 1);
+	if (size == 0 || size > ring_capacity) {
+		return false;
+	}
+
+	retire();
+	if (head + size > ring_capacity) {
+		//wrap, the bytes before the wrap get their own fence so the span stays contiguous
+		fence_open_span();
+		head = 0;
+		open_begin = 0;
+	}
+	for (const Span &span : in_flight) {
+		if (head < span.end && span.begin < head + size) {
+			return false;	//the GPU may still be copying out of these bytes
+		}
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	uint8_t *mapped = (uint8_t *)glMapBufferRange(GL_COPY_READ_BUFFER, head, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!mapped) {
+		return false;
+	}
+	for (int i = 0; i < part_count; ++i) {
+		std::memcpy(mapped, parts[i], sizes[i]);
+		mapped += sizes[i];
+	}
+	glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+	offset = head;
+	head += size;
+	return true;
+}
+
+void UploadRing::copy(size_t offset, GLuint destination, size_t destination_offset, size_t size) {
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, destination_offset, size);
+}
+
+void UploadRing::end_frame() {
+	fence_open_span();
+}
+
+void UploadRing::fence_open_span() {
+	if (head > open_begin) {
+		in_flight.push_back({ open_begin, head, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+	}
+	open_begin = head;
+}
+
+//drops the fences the GPU has passed, oldest first, without waiting on any
+void UploadRing::retire() {
+	while (!in_flight.empty()) {
+		GLenum status = glClientWaitSync(in_flight.front().fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		glDeleteSync(in_flight.front().fence);
+		in_flight.pop_front();
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <deque>
+#include <cstddef>
+#include "glad/glad.h"
+
+//staging buffer for streaming mesh data to the GPU. data is written into the next free part of one large
+//buffer through an unsynchronized glMapBufferRange and copied into its destination buffer on the GPU with
+//glCopyBufferSubData, so an upload never waits for the driver to finish with earlier ones. every frame's
+//part of the ring is fenced and only written again once its fence has signaled; when the ring is full the
+//upload is refused instead of stalling and the caller retries it next frame
+class UploadRing {
+
+public:
+
+	static constexpr size_t DEFAULT_CAPACITY = 16 * 1024 * 1024;
+
+	UploadRing() = default;
+	~UploadRing();
+	UploadRing(const UploadRing &) = delete;
+	UploadRing &operator=(const UploadRing &) = delete;
+
+	//creates the staging buffer, needs a current GL context
+	void init(size_t capacity = DEFAULT_CAPACITY);
+	bool initialized() const { return buffer != 0; }
+	size_t capacity() const { return ring_capacity; }
+
+	//copies the parts into consecutive space in the ring and returns where the first one starts, the rest
+	//follow it without padding. false when there is no space until an older frame's fence signals
+	bool stage(const void *const *parts, const size_t *sizes, int part_count, size_t &offset);
+	//copies staged bytes into another buffer. the ring stays bound to GL_COPY_READ_BUFFER, the destination
+	//is bound to GL_COPY_WRITE_BUFFER
+	void copy(size_t offset, GLuint destination, size_t destination_offset, size_t size);
+	//fences everything staged since the last call, call once a frame after the frame's uploads
+	void end_frame();
+
+private:
+
+	struct Span {
+		size_t begin;
+		size_t end;
+		GLsync fence;
+	};
+
+	void fence_open_span();
+	void retire();
+
+	GLuint buffer = 0;
+	size_t ring_capacity = 0;
+	size_t head = 0;			//next byte to write
+	size_t open_begin = 0;		//start of the bytes staged since the last fence
+	std::deque<Span> in_flight;	//oldest first
+};
+
+#endif // !UPLOAD_RING_H